@@ -0,0 +1,90 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#ifndef BITVECTOR_H
+#define BITVECTOR_H
+
+#include <cstddef>
+#include <stdint.h>
+
+// A vector of bits packed into 64-bit words, ordered like a vector<bool>. The
+// bits are stored from the most significant end of each word, so comparing
+// the words as integers compares the bits lexicographically. Vectors of up to
+// kInlineBits bits, which covers the usual neighborhoods, need no allocation.
+class BitVector {
+    public:
+        static const size_t kInlineBits = 128;
+
+        BitVector() : size_(0), num_words_(0), words_(inline_) { }
+        ~BitVector() {
+            if (words_ != inline_)
+                delete[] words_;
+        }
+
+        // Resizes the vector to size bits, all cleared.
+        void Assign(size_t size) {
+            if (words_ != inline_)
+                delete[] words_;
+            size_ = size;
+            num_words_ = (size + 63) / 64;
+            words_ = size <= kInlineBits ? inline_ : new uint64_t[num_words_];
+            for (size_t i = 0; i < num_words_; ++i)
+                words_[i] = 0;
+        }
+
+        inline size_t size() const { return size_; }
+        inline bool Test(size_t i) const { return words_[i >> 6] & Mask(i); }
+        inline void Set(size_t i) { words_[i >> 6] |= Mask(i); }
+        inline void Reset(size_t i) { words_[i >> 6] &= ~Mask(i); }
+
+        // Returns the index of the first set bit at or after i, or size() if
+        // there is none.
+        inline size_t Next(size_t i) const {
+            if (i >= size_)
+                return size_;
+            size_t w = i >> 6;
+            uint64_t word = words_[w] & (~0ULL >> (i & 63));
+            while (!word) {
+                if (++w == num_words_)
+                    return size_;
+                word = words_[w];
+            }
+            return (w << 6) + __builtin_clzll(word);
+        }
+
+        // Compares two vectors of the same size lexicographically.
+        inline int Compare(const BitVector& that) const {
+            for (size_t i = 0; i < num_words_; ++i) {
+                if (words_[i] != that.words_[i])
+                    return words_[i] < that.words_[i] ? -1 : 1;
+            }
+            return 0;
+        }
+
+    private:
+        size_t size_;
+        size_t num_words_;
+        uint64_t* words_;
+        uint64_t inline_[kInlineBits / 64];
+
+        static inline uint64_t Mask(size_t i) { return 0x8000000000000000ULL >> (i & 63); }
+
+        BitVector(const BitVector&);
+        void operator=(const BitVector&);
+};
+
+#endif // BITVECTOR_H
@@ -152,7 +152,7 @@ void CanonicalAstConverter::VisitDoWhileStatement(DoWhileStatement* node) {
 	Assignment* update = factory_.NewAssignment(Token::ASSIGN, condition, node->cond(), RelocInfo::kNoPosition);
 	body->statements()->Add(factory_.NewExpressionStatement(update), isolate()->runtime_zone());
     }
-    Block* block = reinterpret_cast<Block*>(StatementCopier().Copy(body));
+    Block* block = reinterpret_cast<Block*>(StatementCopier(isolate()).Copy(body));
     WhileStatement *loop = factory_.NewWhileStatement(NULL);
     loop->Initialize(condition, body);
     block->AddStatement(loop, isolate()->runtime_zone());
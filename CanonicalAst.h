@@ -171,7 +171,7 @@ class CanonicalAstVisitor : public AstVisitor {
 template<class Visitor> class CanonicalNodeFactory : public AstNodeFactory<Visitor> {
     public:
 	explicit CanonicalNodeFactory(Isolate *isolate)
-	    : AstNodeFactory<Visitor>(isolate, isolate->runtime_zone()), isolate_(isolate), zone_(isolate->runtime_zone()) { }
+	    : AstNodeFactory<Visitor>(isolate, isolate->runtime_zone()), isolate_(isolate), zone_(isolate->runtime_zone()), temporaries_(0) { }
 
 	CanonicalFunctionEntry* NewCanonicalFunctionEntry(FunctionLiteral* literal, ZoneList<Statement*>* body) {
 	    ZoneList<Variable*>* params = new(zone_) ZoneList<Variable*>(literal->scope()->num_parameters(), zone_);
@@ -202,9 +202,8 @@ template<class Visitor> class CanonicalNodeFactory : public AstNodeFactory<Visit
 #endif
 
 	VariableProxy* NewTemporary(Scope* scope) {
-    	    static int count = 0;
 	    char buf[16];
-	    sprintf(buf, "$%d", count++);
+	    sprintf(buf, "$%d", temporaries_++);
 	    Handle<String> name = isolate_->factory()->LookupAsciiSymbol(buf);
 	    return this->NewVariableProxy(scope->NewTemporary(name));
 	}
@@ -212,6 +211,7 @@ template<class Visitor> class CanonicalNodeFactory : public AstNodeFactory<Visit
     private:
 	Isolate* isolate_;
 	Zone* zone_;
+	int temporaries_;
 };
 
 template <class T>
@@ -237,7 +237,7 @@ class ZoneListIterator {
 class CanonicalAstConverter : public AstVisitor {
     public:
 
-	CanonicalAstConverter() : isolate_(Isolate::Current()), factory_(isolate_) { }
+	explicit CanonicalAstConverter(Isolate* isolate) : isolate_(isolate), factory_(isolate_) { }
 
 	void Visit(AstNode* node) { node->Accept(this); }
 	// Individual nodes
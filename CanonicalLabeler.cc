@@ -0,0 +1,279 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#include "CanonicalLabeler.h"
+
+#include <algorithm>
+#include <sstream>
+
+using std::make_pair;
+using std::ostringstream;
+using std::pair;
+using std::sort;
+using std::unique;
+
+namespace {
+
+// Orders vertices by a key vector per vertex.
+struct KeyLess {
+    explicit KeyLess(const vector<vector<int> >& keys) : keys_(keys) { }
+    inline bool operator() (int x, int y) const { return keys_[x] < keys_[y]; }
+    private: const vector<vector<int> >& keys_;
+};
+
+struct LabelLess {
+    explicit LabelLess(const vector<pair<string,bool> >& labels) : labels_(labels) { }
+    inline bool operator() (int x, int y) const { return labels_[x] < labels_[y]; }
+    private: const vector<pair<string,bool> >& labels_;
+};
+
+}
+
+int CanonicalLabeler::AddVertex(const string& label, bool focal) {
+    Vertex vertex;
+    vertex.label = label;
+    vertex.focal = focal;
+    vertices_.push_back(vertex);
+    return vertices_.size() - 1;
+}
+
+void CanonicalLabeler::AddEdge(int from, int to) {
+    vertices_[from].predecessors.push_back(to);
+    vertices_[to].successors.push_back(from);
+}
+
+bool CanonicalLabeler::Label(string* pattern) {
+    for (vector<Vertex>::iterator i = vertices_.begin(); i != vertices_.end(); ++i) {
+        sort(i->predecessors.begin(), i->predecessors.end());
+        i->predecessors.erase(unique(i->predecessors.begin(), i->predecessors.end()), i->predecessors.end());
+        sort(i->successors.begin(), i->successors.end());
+        i->successors.erase(unique(i->successors.begin(), i->successors.end()), i->successors.end());
+    }
+    count_ = 0;
+    abandoned_ = false;
+    path_.clear();
+    first_order_.clear();
+    automorphisms_.clear();
+
+    Partition partition = InitialPartition();
+    Refine(&partition);
+    Search(partition);
+    if (abandoned_)
+        return false;
+    *pattern = best_pattern_;
+    return true;
+}
+
+CanonicalLabeler::Partition CanonicalLabeler::InitialPartition() const {
+    vector<pair<string,bool> > labels;
+    vector<int> order;
+    for (size_t v = 0; v < vertices_.size(); ++v) {
+        labels.push_back(make_pair(vertices_[v].label, vertices_[v].focal));
+        order.push_back(v);
+    }
+    sort(order.begin(), order.end(), LabelLess(labels));
+    Partition partition(vertices_.size());
+    for (size_t i = 0, start = 0; i < order.size(); ++i) {
+        if (labels[order[i]] != labels[order[start]])
+            start = i;
+        partition[order[i]] = start;
+    }
+    return partition;
+}
+
+static size_t CountCells(const vector<int>& partition) {
+    vector<bool> used(partition.size(), false);
+    size_t num_cells = 0;
+    for (size_t v = 0; v < partition.size(); ++v) {
+        if (!used[partition[v]]) {
+            used[partition[v]] = true;
+            ++num_cells;
+        }
+    }
+    return num_cells;
+}
+
+// Splits cells by the colors of the predecessors and the successors of their
+// vertices until nothing changes. The new cells are ordered by those colors,
+// so that the result does not depend on how the vertices are numbered.
+void CanonicalLabeler::Refine(Partition* partition) const {
+    const size_t n = vertices_.size();
+    vector<int> order(n);
+    vector<vector<int> > keys(n);
+    size_t num_cells = CountCells(*partition);
+    while (num_cells < n) {
+        for (size_t v = 0; v < n; ++v) {
+            vector<int>& key = keys[v];
+            key.clear();
+            key.push_back((*partition)[v]);
+            for (vector<int>::const_iterator i = vertices_[v].predecessors.begin(); i != vertices_[v].predecessors.end(); ++i)
+                key.push_back((*partition)[*i]);
+            sort(key.begin() + 1, key.end());
+            key.push_back(-1);
+            size_t mark = key.size();
+            for (vector<int>::const_iterator i = vertices_[v].successors.begin(); i != vertices_[v].successors.end(); ++i)
+                key.push_back((*partition)[*i]);
+            sort(key.begin() + mark, key.end());
+            order[v] = v;
+        }
+        sort(order.begin(), order.end(), KeyLess(keys));
+        size_t new_num_cells = 0;
+        for (size_t i = 0, start = 0; i < n; ++i) {
+            if (i == 0 || keys[order[i]] != keys[order[start]]) {
+                start = i;
+                ++new_num_cells;
+            }
+            (*partition)[order[i]] = start;
+        }
+        if (new_num_cells == num_cells)
+            break;
+        num_cells = new_num_cells;
+    }
+}
+
+// Returns the depth of the search node to go back to.
+size_t CanonicalLabeler::Search(const Partition& partition) {
+    const size_t depth = path_.size();
+
+    // the first cell with more than one vertex
+    const size_t n = vertices_.size();
+    vector<int> sizes(n, 0);
+    for (size_t v = 0; v < n; ++v)
+        ++sizes[partition[v]];
+    int target = -1;
+    for (size_t c = 0; c < n && target < 0; c += sizes[c] ? sizes[c] : 1) {
+        if (sizes[c] > 1)
+            target = c;
+    }
+    if (target < 0)
+        return VisitLeaf(partition);
+
+    vector<int> cell;
+    for (size_t v = 0; v < n; ++v) {
+        if (partition[v] == target)
+            cell.push_back(v);
+    }
+    vector<int> tried;
+    vector<int> orbits;
+    for (vector<int>::iterator v = cell.begin(); v != cell.end(); ++v) {
+        // skip a vertex mapped to a tried one by an automorphism fixing the path
+        if (!tried.empty() && !automorphisms_.empty()) {
+            orbits.resize(n);
+            for (size_t i = 0; i < n; ++i)
+                orbits[i] = i;
+            for (vector<vector<int> >::iterator a = automorphisms_.begin(); a != automorphisms_.end(); ++a) {
+                size_t i;
+                for (i = 0; i < depth && (*a)[path_[i]] == path_[i]; ++i)
+                    ;
+                if (i < depth)
+                    continue;
+                for (size_t u = 0; u < n; ++u)
+                    orbits[FindOrbit(&orbits, u)] = FindOrbit(&orbits, (*a)[u]);
+            }
+            size_t i;
+            for (i = 0; i < tried.size() && FindOrbit(&orbits, tried[i]) != FindOrbit(&orbits, *v); ++i)
+                ;
+            if (i < tried.size())
+                continue;
+        }
+
+        Partition child = partition;
+        for (vector<int>::iterator u = cell.begin(); u != cell.end(); ++u)
+            child[*u] = target + 1;
+        child[*v] = target;
+        Refine(&child);
+        path_.push_back(*v);
+        size_t level = Search(child);
+        path_.pop_back();
+        if (abandoned_)
+            return 0;
+        if (level < depth)
+            return level;
+        tried.push_back(*v);
+    }
+    return depth;
+}
+
+size_t CanonicalLabeler::VisitLeaf(const Partition& partition) {
+    if (count_limit_ && count_ == count_limit_) {
+        abandoned_ = true;
+        return 0;
+    }
+    ++count_;
+    vector<int> order(vertices_.size());
+    for (size_t v = 0; v < vertices_.size(); ++v)
+        order[partition[v]] = v;
+    string pattern = ToPattern(order);
+
+    if (first_order_.empty()) {
+        first_path_ = path_;
+        first_order_ = best_order_ = order;
+        first_pattern_ = best_pattern_ = pattern;
+        return path_.size();
+    }
+    if (pattern == first_pattern_) {
+        // Everything below the node where this branch left the first one is
+        // an image of what has been explored there.
+        AddAutomorphism(first_order_, order);
+        size_t level;
+        for (level = 0; level < path_.size() && path_[level] == first_path_[level]; ++level)
+            ;
+        return level;
+    }
+    if (pattern == best_pattern_) {
+        AddAutomorphism(best_order_, order);
+    } else if (pattern < best_pattern_) {
+        best_order_ = order;
+        best_pattern_ = pattern;
+    }
+    return path_.size();
+}
+
+string CanonicalLabeler::ToPattern(const vector<int>& order) const {
+    vector<int> position(order.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        position[order[i]] = i;
+    ostringstream pattern;
+    vector<int> adjacency;
+    for (size_t i = 0; i < order.size(); ++i) {
+        const Vertex& vertex = vertices_[order[i]];
+        pattern << (vertex.focal ? '[' : '(') << vertex.label;
+        adjacency.clear();
+        for (vector<int>::const_iterator j = vertex.predecessors.begin(); j != vertex.predecessors.end(); ++j)
+            adjacency.push_back(position[*j]);
+        sort(adjacency.begin(), adjacency.end());
+        for (vector<int>::iterator j = adjacency.begin(); j != adjacency.end(); ++j)
+            pattern << ' ' << *j;
+        pattern << (vertex.focal ? ']' : ')');
+    }
+    return pattern.str();
+}
+
+void CanonicalLabeler::AddAutomorphism(const vector<int>& from, const vector<int>& to) {
+    vector<int> automorphism(from.size());
+    for (size_t i = 0; i < from.size(); ++i)
+        automorphism[from[i]] = to[i];
+    automorphisms_.push_back(automorphism);
+}
+
+int CanonicalLabeler::FindOrbit(vector<int>* orbits, int v) const {
+    while ((*orbits)[v] != v) {
+        (*orbits)[v] = (*orbits)[(*orbits)[v]];
+        v = (*orbits)[v];
+    }
+    return v;
+}
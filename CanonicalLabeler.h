@@ -0,0 +1,90 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#ifndef CANONICALLABELER_H
+#define CANONICALLABELER_H
+
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+// Computes a canonical pattern of a small labeled directed graph by
+// individualization-refinement. Vertices are first partitioned by their
+// labels, and the partition is refined until it is equitable, i.e., until
+// vertices in the same cell have the same number of predecessors and of
+// successors in every cell. A non-singleton cell is then split by trying each
+// of its vertices in a cell of its own, and the search goes on until the
+// partition is discrete and gives an order of the vertices. The pattern is the
+// smallest one over all the orders reached; it is written like the ones of the
+// order search in PDGExtractor, "(label j ...)" per vertex ("[...]" for the
+// focal one) with j running over the positions of its predecessors.
+//
+// Automorphisms are found whenever two orders give the same pattern, and are
+// used to skip the children of a search node that are equivalent to ones
+// already explored, and to jump back to the node where the current branch left
+// the first one.
+class CanonicalLabeler {
+    public:
+        // The search gives up after count_limit orders; 0 means no limit.
+        explicit CanonicalLabeler(size_t count_limit = 0) : count_limit_(count_limit) { }
+
+        // Returns the index of the new vertex.
+        int AddVertex(const string& label, bool focal);
+        // Makes to a predecessor of from.
+        void AddEdge(int from, int to);
+
+        // Returns false if the search is abandoned.
+        bool Label(string* pattern);
+
+        inline size_t count() const { return count_; }
+
+    private:
+        struct Vertex {
+            string label;
+            bool focal;
+            vector<int> predecessors;
+            vector<int> successors;
+        };
+
+        // A partition is stored as the color of every vertex, which is the
+        // position of the first vertex of its cell in the order.
+        typedef vector<int> Partition;
+
+        const size_t count_limit_;
+        size_t count_;
+        vector<Vertex> vertices_;
+        vector<int> path_;  // individualized vertices
+        vector<int> first_path_;
+        vector<int> first_order_;
+        string first_pattern_;
+        vector<int> best_order_;
+        string best_pattern_;
+        vector<vector<int> > automorphisms_;
+        bool abandoned_;
+
+        Partition InitialPartition() const;
+        void Refine(Partition* partition) const;
+        size_t Search(const Partition& partition);
+        size_t VisitLeaf(const Partition& partition);
+        string ToPattern(const vector<int>& order) const;
+        void AddAutomorphism(const vector<int>& from, const vector<int>& to);
+        int FindOrbit(vector<int>* orbits, int v) const;
+};
+
+#endif // CANONICALLABELER_H
@@ -20,18 +20,18 @@
 #include <v8.h>
 #include <scopes.h>
 #include <checks.h>
+#include <algorithm>
 #include <cwctype>
-#include <utility>
 
 #define LINENO_WIDTH 5
 
-using std::make_pair;
+using std::binary_search;
 
-CodePrinter::CodePrinter(FunctionLiteral* program) {
+CodePrinter::CodePrinter(FunctionLiteral* program, const DependenceGraph& graph)
+    : program_(program), graph_(graph), lineno_(graph.size()), funcno_(graph.size()) {
     const int initial_size = 256;
     output_ = NewArray<char>(initial_size);
     size_ = initial_size;
-    program_ = program;
     PrintProgram();
 }
 
@@ -116,11 +116,11 @@ void CodePrinter::VisitEmptyStatement(EmptyStatement* node) {
 }
 
 void CodePrinter::VisitIfStatement(IfStatement* node) {
-    PrintLineNo(node);
+    const int id = PrintLineNo(node);
     Print("%*sif (", indent_, "");
     Visit(node->condition());
     Print(") {");
-    PrintDependence(node);
+    PrintDependence(id);
     Print("\n");
     indent_ += 4;
     Visit(node->then_statement());
@@ -134,7 +134,7 @@ void CodePrinter::VisitIfStatement(IfStatement* node) {
 }
 
 void CodePrinter::VisitContinueStatement(ContinueStatement* node) {
-    PrintLineNo(node);
+    const int id = PrintLineNo(node);
     Print("%*scontinue;", indent_, "");
     ZoneStringList* labels = node->target()->labels();
     if (labels != NULL) {
@@ -142,13 +142,13 @@ void CodePrinter::VisitContinueStatement(ContinueStatement* node) {
 	ASSERT(labels->length() > 0);  // guaranteed to have at least one entry
 	PrintLiteral(labels->at(0), false);  // any label from the list is fine
     }
-    PrintDependence(node);
+    PrintDependence(id);
     Print("\n");
     //ExitStatement(node);
 }
 
 void CodePrinter::VisitBreakStatement(BreakStatement* node) {
-    PrintLineNo(node);
+    const int id = PrintLineNo(node);
     Print("%*sbreak;", indent_, "");
     ZoneStringList* labels = node->target()->labels();
     if (labels != NULL) {
@@ -156,17 +156,17 @@ void CodePrinter::VisitBreakStatement(BreakStatement* node) {
 	ASSERT(labels->length() > 0);  // guaranteed to have at least one entry
 	PrintLiteral(labels->at(0), false);  // any label from the list is fine
     }
-    PrintDependence(node);
+    PrintDependence(id);
     Print("\n");
     //ExitStatement(node);
 }
 
 void CodePrinter::VisitReturnStatement(ReturnStatement* node) {
-    PrintLineNo(node);
+    const int id = PrintLineNo(node);
     Print("%*sreturn ", indent_, "");
     Visit(node->expression());
     Print(";");
-    PrintDependence(node);
+    PrintDependence(id);
     Print("\n");
     //ExitStatement(node);
 }
@@ -181,13 +181,13 @@ void CodePrinter::VisitWithStatement(WithStatement* node) {
 }
 
 void CodePrinter::VisitSwitchStatement(SwitchStatement* node) {
-    PrintLineNo(node);
+    const int id = PrintLineNo(node);
     Print("%*s", indent_, "");
     PrintLabels(node->labels());
     Print("switch (");
     Visit(node->tag());
     Print(") {");
-    PrintDependence(node);
+    PrintDependence(id);
     Print("\n");
     indent_ += 4;
     ZoneList<CaseClause*>* cases = node->cases();
@@ -203,13 +203,13 @@ void CodePrinter::VisitDoWhileStatement(DoWhileStatement* node) {
 }
 
 void CodePrinter::VisitWhileStatement(WhileStatement* node) {
-    PrintLineNo(node);
+    const int id = PrintLineNo(node);
     Print("%*s", indent_, "");
     PrintLabels(node->labels());
     Print("while (");
     Visit(node->cond());
     Print(") {");
-    PrintDependence(node);
+    PrintDependence(id);
     Print("\n");
     indent_ += 4;
     Visit(node->body());
@@ -223,7 +223,7 @@ void CodePrinter::VisitForStatement(ForStatement* node) {
 }
 
 void CodePrinter::VisitForInStatement(ForInStatement* node) {
-    PrintLineNo(node);
+    const int id = PrintLineNo(node);
     Print("%*s", indent_, "");
     PrintLabels(node->labels());
     Print("for (");
@@ -231,7 +231,7 @@ void CodePrinter::VisitForInStatement(ForInStatement* node) {
     Print(" in ");
     Visit(node->enumerable());
     Print(") {");
-    PrintDependence(node);
+    PrintDependence(id);
     Print("\n");
     indent_ += 4;
     Visit(node->body());
@@ -260,9 +260,9 @@ void CodePrinter::VisitTryFinallyStatement(TryFinallyStatement* node) {
 }
 
 void CodePrinter::VisitDebuggerStatement(DebuggerStatement* node) {
-    PrintLineNo(node);
+    const int id = PrintLineNo(node);
     Print("%*sdebugger;", indent_, "");
-    PrintDependence(node);
+    PrintDependence(id);
     Print("\n");
     //ExitStatement(node);
 }
@@ -396,11 +396,11 @@ void CodePrinter::VisitThisFunction(ThisFunction* node) {
 }
 
 void CodePrinter::VisitCanonicalFunctionEntry(CanonicalFunctionEntry* node) {
-    func_stack_.push(lineno_.size() + 1);
-    func_[lineno_.size() + 1] = node;
-    PrintLineNo(node);
+    func_stack_.push(line_.size() + 1);
+    func_[line_.size() + 1] = node;
+    const int id = PrintLineNo(node);
     Print("%*sbegin;", indent_, "");
-    PrintDependence(node);
+    PrintDependence(id);
     Print("\n");
     //indent_ += 4;
     PrintDeclarations(node->declarations());
@@ -409,34 +409,34 @@ void CodePrinter::VisitCanonicalFunctionEntry(CanonicalFunctionEntry* node) {
 }
 
 void CodePrinter::VisitCanonicalAssignment(CanonicalAssignment* node) {
-    PrintLineNo(node);
+    const int id = PrintLineNo(node);
     Print("%*s", indent_, "");
     Visit(node->target());
     Print(" = ");
     Visit(node->value());
     Print(";");
-    PrintDependence(node);
+    PrintDependence(id);
     Print("\n");
     //ExitStatement(node);
 }
 
 void CodePrinter::VisitCanonicalPropertyAssignment(CanonicalPropertyAssignment* node) {
-    PrintLineNo(node);
+    const int id = PrintLineNo(node);
     Print("%*s", indent_, "");
     Visit(node->target());
     Print(" = ");
     Visit(node->value());
     Print(";");
-    PrintDependence(node);
+    PrintDependence(id);
     Print("\n");
     //ExitStatement(node);
 }
 
 void CodePrinter::VisitCanonicalFunctionExit(CanonicalFunctionExit* node) {
-    PrintLineNo(node);
+    const int id = PrintLineNo(node);
     //indent_ -= 4;
     Print("%*send;", indent_, "");
-    PrintDependence(node);
+    PrintDependence(id);
     Print("\n");
     //ExitStatement(node);
     func_stack_.pop();
@@ -486,22 +486,19 @@ const char* CodePrinter::PrintProgram() {
     return output_;
 }
 
-const char* CodePrinter::Print(AstNode* node, const DependenceGraph& graph, const list<Statement*>& succ) {
+const char* CodePrinter::Print(AstNode* node, const NeighborhoodGrower* neighborhood) {
     Init();
-    graph_ = &graph;
-    successors_.clear();
-    successors_.insert(succ.begin(), succ.end());
+    fragment_ = true;
+    neighborhood_ = neighborhood;
     Visit(node);
     return output_;
 }
 
 const char* CodePrinter::PrintFunc(FunctionLiteral* node) {
     Init();
-    graph_ = new DependenceGraph;
-    successors_.clear();
+    fragment_ = true;
     func_stack_.push(0);
     Visit(node);
-    delete graph_;
     return output_;
 }
 
@@ -514,7 +511,8 @@ void CodePrinter::Init() {
     output_[0] = '\0';
     pos_ = 0;
     indent_ = 0;
-    graph_ = NULL;
+    fragment_ = false;
+    neighborhood_ = NULL;
 }
 
 void CodePrinter::Print(const char* format, ...) {
@@ -636,15 +634,15 @@ void CodePrinter::PrintFunctionLiteral(FunctionLiteral* function) {
     PrintLiteral(function->name(), false);
     PrintParameters(function->scope());
     // print the contents if printing the whole program or this function
-    if (!graph_ || func_stack_.empty()) {
-    	if (!graph_) {
+    if (!fragment_ || func_stack_.empty()) {
+    	if (!fragment_) {
 	    Print(" {\n");
 	    indent_ += 4;
 	} else {
 	    Print(":\n");
 	}
 	PrintStatements(function->body());
-	if (!graph_) {
+	if (!fragment_) {
 	    indent_ -= 4;
 	    Print("%*s  %*s}", LINENO_WIDTH, "", indent_, "");
 	}
@@ -666,25 +664,48 @@ void CodePrinter::PrintCaseClause(CaseClause* clause) {
     indent_ -= 4;
 }
 
-void CodePrinter::PrintDependence(Statement* node) {
-    if (graph_ && graph_->count(node)) {
+void CodePrinter::PrintDependence(int id) {
+    if (!neighborhood_ || id < 0)
+    	return;
+    int slot = neighborhood_->slot(id);
+    if (slot >= 0) {
 	Print(" [");
-	for (list<Statement*>::const_iterator iter = graph_->at(node).begin(); iter != graph_->at(node).end(); ++iter) {
-	    if (lineno_.count(*iter))
-		Print(iter == graph_->at(node).begin() ? "%d" : ", %d", lineno_[*iter]);
+	if (static_cast<size_t>(slot) < neighborhood_->num_expanded()) {
+	    DependenceGraph::Ids predecessors = graph_.predecessors(id);
+	    for (DependenceGraph::Ids::const_iterator iter = predecessors.begin(); iter != predecessors.end(); ++iter) {
+		if (lineno_[*iter])
+		    Print(iter == predecessors.begin() ? "%d" : ", %d", lineno_[*iter]);
+	    }
 	}
 	Print("]");
     }
 }
 
-void CodePrinter::PrintLineNo(Statement* node) {
-    if (!lineno_.count(node)) {
-    	line_.push_back(node);
-	lineno_.insert(make_pair(node, line_.size()));
-	funcno_[node] = func_stack_.top();
+// Every statement printed is in the graph, as the builder gives an id to every
+// statement of the lists the printer goes through. One that is not anyway is
+// printed without a number, so that no line stands for it.
+int CodePrinter::PrintLineNo(Statement* node) {
+    int id = graph_.id(node);
+    if (id < 0) {
+	Print("%*s  ", LINENO_WIDTH, "");
+	return id;
+    }
+    if (!lineno_[id]) {
+    	line_.push_back(id);
+	lineno_[id] = line_.size();
+	funcno_[id] = func_stack_.top();
     }
     //flag_stack_.push(!graph_ || graph_->count(node));
-    Print("%*d%c ", LINENO_WIDTH, lineno_[node], graph_ && graph_->count(node) ? '*' : successors_.count(node) ? '>' : ' ');
+    char mark = ' ';
+    if (neighborhood_) {
+	DependenceGraph::Ids successors = graph_.successors(neighborhood_->node());
+	if (neighborhood_->slot(id) >= 0)
+	    mark = '*';
+	else if (binary_search(successors.begin(), successors.end(), id))
+	    mark = '>';
+    }
+    Print("%*d%c ", LINENO_WIDTH, lineno_[id], mark);
+    return id;
 }
 
 /*void CodePrinter::ExitStatement(Statement* node) {
@@ -18,30 +18,29 @@
 #ifndef CODEPRINTER_H
 #define CODEPRINTER_H
 
-#include <list>
 #include <map>
-#include <set>
 #include <stack>
 #include <vector>
 #include "CanonicalAst.h"
 #include "DependenceGraph.h"
 
 using namespace v8::internal;
-using std::list;
 using std::map;
-using std::set;
 using std::stack;
 using std::vector;
 
 class CodePrinter: public CanonicalAstVisitor {
     public:
-	CodePrinter(FunctionLiteral* program);
+	// Statements are numbered by their ids in graph.
+	CodePrinter(FunctionLiteral* program, const DependenceGraph& graph);
 	virtual ~CodePrinter();
 
 	// The following routines print a node into a string.
 	// The result string is alive as long as the CodePrinter is alive.
 	const char* PrintProgram();
-	const char* Print(AstNode* node, const DependenceGraph& graph = DependenceGraph(), const list<Statement*>& succ = list<Statement*>());
+	// Statements in the neighborhood are marked with '*' and listed with
+	// their dependences, and the successors of its node are marked with '>'.
+	const char* Print(AstNode* node, const NeighborhoodGrower* neighborhood = NULL);
 	const char* PrintFunc(FunctionLiteral* node);
 
 	void Print(const char* format, ...);
@@ -56,10 +55,11 @@ class CodePrinter: public CanonicalAstVisitor {
 #undef DECLARE_VISIT
 
 	inline const char* GetOutput() const { return output_; }
-	inline int GetLineNo(Statement* node) const { return lineno_.at(node); }
-	inline int GetFuncNo(Statement* node) const { return funcno_.at(node); }
-	inline int CompareNode(Statement* const& x, Statement* const& y) const { return lineno_.at(x) - lineno_.at(y); }
-	inline Statement* GetLine(int lineno) const { return line_.at(lineno - 1); }
+	// Statements are given and returned as ids.
+	inline int GetLineNo(int node) const { return lineno_[node]; }
+	inline int GetFuncNo(int node) const { return funcno_[node]; }
+	inline int CompareNode(const int& x, const int& y) const { return lineno_[x] - lineno_[y]; }
+	inline int GetLine(int lineno) const { return line_.at(lineno - 1); }
 	inline Statement* GetFunc(int funcno) const { return func_.at(funcno); }
 	inline const map<int,Statement*>& GetFuncList() const { return func_; }
 	inline size_t NumLines() const { return line_.size(); }
@@ -70,12 +70,13 @@ class CodePrinter: public CanonicalAstVisitor {
 	int pos_;  // current printing position
 	int indent_;
 	FunctionLiteral* program_;
-	vector<Statement*> line_;
+	const DependenceGraph& graph_;
+	vector<int> line_;  // ids by line
 	map<int,Statement*> func_;
-	map<Statement*,int> lineno_;
-	map<Statement*,int> funcno_;
-	const DependenceGraph* graph_;
-	set<Statement*> successors_;
+	vector<int> lineno_;  // by id, 0 if not printed yet
+	vector<int> funcno_;  // by id
+	bool fragment_;  // printing a function or a neighborhood, not the program
+	const NeighborhoodGrower* neighborhood_;
 	stack<int> func_stack_;
 	//stack<bool> flag_stack_;
 
@@ -90,8 +91,9 @@ class CodePrinter: public CanonicalAstVisitor {
 	void PrintDeclarations(ZoneList<Declaration*>* declarations);
 	void PrintFunctionLiteral(FunctionLiteral* function);
 	void PrintCaseClause(CaseClause* clause);
-	void PrintDependence(Statement* node);
-	void PrintLineNo(Statement* node);
+	void PrintDependence(int id);
+	// Returns the id of the statement, or -1 if it is not in the graph.
+	int PrintLineNo(Statement* node);
 	//void ExitStatement(Statement* node);
 };
 
@@ -17,13 +17,14 @@
 
 #include "DependenceGraph.h"
 
+#include <algorithm>
 #include <checks.h>
-#include <queue>
 #include <utility>
-#include "Utility.h"
+#include "OperationPrinter.h"
 
 using std::make_pair;
-using std::queue;
+using std::sort;
+using std::unique;
 
 #define DEFINE_UNREACHABLE_VISIT(type) \
 void DependenceGraphBuilder::Visit##type(type* node) { \
@@ -81,7 +82,6 @@ void DependenceGraphBuilder::VisitBreakStatement(BreakStatement* node) {
 
 void DependenceGraphBuilder::VisitReturnStatement(ReturnStatement* node) {
     // TODO: manage control dependence
-    visiting_ = node;
     Visit(node->expression());
 }
 
@@ -152,16 +152,16 @@ void DependenceGraphBuilder::VisitCompareOperation(CompareOperation* node) {
 }
 
 void DependenceGraphBuilder::VisitCanonicalAssignment(CanonicalAssignment* node) {
-    visiting_ = node;
+    const int id = visiting_;
     Visit(node->value());
-    visiting_ = node;
+    visiting_ = id;
     Write(node->target()->var());
 }
 
 void DependenceGraphBuilder::VisitCanonicalPropertyAssignment(CanonicalPropertyAssignment* node) {
-    visiting_ = node;
+    const int id = visiting_;
     Visit(node->value());
-    visiting_ = node;
+    visiting_ = id;
     Visit(node->target()->obj());
     Visit(node->target()->key());
     ASSERT(node->target()->obj()->node_type() == AstNode::kVariableProxy);
@@ -169,162 +169,265 @@ void DependenceGraphBuilder::VisitCanonicalPropertyAssignment(CanonicalPropertyA
 }
 
 void DependenceGraphBuilder::VisitCanonicalFunctionEntry(CanonicalFunctionEntry* node) {
-    Region* outer_region = region_;
-    region_ = new Region(NULL, node);
-    visiting_ = node;
+    EnterRegion(visiting_, true);
     for (int i = 0; i < node->parameters()->length(); ++i)
 	Write(node->parameters()->at(i));
     for (int i = 0; i < node->declarations()->length(); ++i)
 	Visit(node->declarations()->at(i));
     VisitStatements(node->body());
-    delete region_;
-    region_ = outer_region;
+    LeaveRegion(NULL);
 }
 
 void DependenceGraphBuilder::VisitIfStatement(IfStatement* node) {
-    visiting_ = node;
+    const int id = visiting_;
     Visit(node->condition());
-    Region* then_region = new Region(region_, node);
-    Region* else_region = new Region(region_, node);
-    region_ = then_region;
+    vector<pair<int,vector<int> > > defined;
+    EnterRegion(id, false);
     Visit(node->then_statement());
-    region_ = else_region;
+    LeaveRegion(&defined);
+    EnterRegion(id, false);
     Visit(node->else_statement());
-    region_ = then_region->outer_region();
-    delete then_region;
-    //delete else_region;
+    // only the definitions of the then branch reach past the if, as they
+    // always have; merging the else branch too would change the n-grams
+    LeaveRegion(NULL);
+    MergeDefinitions(defined);
 }
 
 void DependenceGraphBuilder::VisitSwitchStatement(SwitchStatement* node) {
-    visiting_ = node;
+    const int id = visiting_;
     Visit(node->tag());
     for (int i = 0; i < node->cases()->length(); ++i) {
 	if (!node->cases()->at(i)->is_default()) {
-	    visiting_ = node;
+	    visiting_ = id;
 	    Visit(node->cases()->at(i)->label());
 	}
     }
-    region_ = new Region(region_, node);
+    vector<pair<int,vector<int> > > defined;
+    EnterRegion(id, false);
     for (int i = 0; i < node->cases()->length(); ++i)
 	VisitStatements(node->cases()->at(i)->statements());
-    Region* inner_region = region_;
-    region_ = inner_region->outer_region();
-    delete inner_region;
+    LeaveRegion(&defined);
+    MergeDefinitions(defined);
 }
 
 void DependenceGraphBuilder::VisitWhileStatement(WhileStatement* node) {
+    const int id = visiting_;
     //for (int i = 0; i < 2; ++i) {
-	visiting_ = node;
+	visiting_ = id;
 	Visit(node->cond());
-	region_ = new Region(region_, node);
+	vector<pair<int,vector<int> > > defined;
+	EnterRegion(id, false);
 	Visit(node->body());
-	Region* inner_region = region_;
-	region_ = inner_region->outer_region();
-	delete inner_region;
+	LeaveRegion(&defined);
+	MergeDefinitions(defined);
     //}
 }
 
 void DependenceGraphBuilder::VisitForInStatement(ForInStatement* node) {
-    visiting_ = node;
+    const int id = visiting_;
     Visit(node->enumerable());
     //for (int i = 0; i < 2; ++i) {
-	visiting_ = node;
+	visiting_ = id;
 	Write(reinterpret_cast<VariableProxy*>(node->each())->var());
-	region_ = new Region(region_, node);
+	vector<pair<int,vector<int> > > defined;
+	EnterRegion(id, false);
 	Visit(node->body());
-	Region* inner_region = region_;
-	region_ = inner_region->outer_region();
-	delete inner_region;
+	LeaveRegion(&defined);
+	MergeDefinitions(defined);
     //}
 }
 
 void DependenceGraphBuilder::Build(FunctionLiteral* program) {
-    visiting_ = NULL;
-    region_ = NULL;
-    graph_.clear();
+    visiting_ = -1;
+    graph_ = DependenceGraph();
+    dependences_.clear();
+    variables_.clear();
+    definitions_.clear();
+    regions_.clear();
     Visit(program);
-    for (value_iterator<DependenceGraph> iter = graph_.begin(); iter != graph_.end(); ++iter) {
-    	iter->sort();
-    	iter->unique();
+    const int size = graph_.size();
+    graph_.types_.reserve(size);
+    graph_.ops_.reserve(size);
+    graph_.predecessor_offsets_.reserve(size + 1);
+    graph_.successor_offsets_.assign(size + 1, 0);
+    OperationPrinter serializer;
+    for (int i = 0; i < size; ++i) {
+    	vector<int>& predecessors = dependences_[i];
+    	sort(predecessors.begin(), predecessors.end());
+    	predecessors.erase(unique(predecessors.begin(), predecessors.end()), predecessors.end());
+    	graph_.predecessor_offsets_.push_back(graph_.predecessors_.size());
+    	graph_.predecessors_.insert(graph_.predecessors_.end(), predecessors.begin(), predecessors.end());
+    	for (vector<int>::iterator j = predecessors.begin(); j != predecessors.end(); ++j)
+    	    ++graph_.successor_offsets_[*j + 1];
+    	graph_.types_.push_back(graph_.statements_[i]->node_type());
+    	graph_.ops_.push_back(serializer.Print(graph_.statements_[i]));
     }
-    for (DependenceGraph::iterator i = graph_.begin(); i != graph_.end(); ++i) {
-	reverse_graph_.insert(make_pair(i->first, list<Statement*>()));
-    	for (list<Statement*>::iterator j = i->second.begin(); j != i->second.end(); ++j)
-    	    reverse_graph_[*j].push_back(i->first);
+    graph_.predecessor_offsets_.push_back(graph_.predecessors_.size());
+
+    // the successors are placed by counting, which leaves them sorted
+    for (int i = 0; i < size; ++i)
+    	graph_.successor_offsets_[i + 1] += graph_.successor_offsets_[i];
+    graph_.successors_.resize(graph_.predecessors_.size());
+    vector<int> next(graph_.successor_offsets_.begin(), graph_.successor_offsets_.end() - 1);
+    for (int i = 0; i < size; ++i) {
+    	for (vector<int>::iterator j = dependences_[i].begin(); j != dependences_[i].end(); ++j)
+    	    graph_.successors_[next[*j]++] = i;
     }
+    vector<vector<int> >().swap(dependences_);
+    vector<vector<Definitions> >().swap(definitions_);
 }
 
+// Every statement but a block gets its id here, before it is visited, and
+// becomes the one being visited.
 void DependenceGraphBuilder::VisitStatements(ZoneList<Statement*>* stmts) {
     for (int i = 0; i < stmts->length(); ++i) {
-        switch (static_cast<int>(stmts->at(i)->node_type())) {
-            case kCanonicalFunctionEntry:
-            case kCanonicalFunctionExit:
-                graph_.insert(make_pair(stmts->at(i), list<Statement*>()));
-            case AstNode::kBlock:
-                break;
-            default:
-                if (region_)
-                graph_[stmts->at(i)].push_back(region_->entry());
-	}
+        if (stmts->at(i)->node_type() != AstNode::kBlock) {
+            visiting_ = graph_.size();
+            graph_.statements_.push_back(stmts->at(i));
+            graph_.ids_[stmts->at(i)] = visiting_;
+            dependences_.push_back(vector<int>());
+            switch (static_cast<int>(stmts->at(i)->node_type())) {
+                case kCanonicalFunctionEntry:
+                case kCanonicalFunctionExit:
+                    break;
+                default:
+                    if (!regions_.empty())
+                        dependences_[visiting_].push_back(regions_.back().entry);
+            }
+        }
 	Visit(stmts->at(i));
     }
 }
 
 void DependenceGraphBuilder::Read(Variable* var) {
-    for (pair<list<Statement*>::const_iterator,list<Statement*>::const_iterator> rdefs = region_->Find(var); rdefs.first != rdefs.second; ++rdefs.first)
-	graph_[visiting_].push_back(*rdefs.first);
+    const int number = Number(var);
+    const int base = regions_.back().base;
+    vector<Definitions>& definitions = definitions_[number];
+    if (definitions.empty() || definitions.back().depth < base) {
+    	// reached by the entry of the function, as if it were defined there
+    	definitions.push_back(Definitions());
+    	definitions.back().depth = base;
+    	definitions.back().statements.push_back(regions_[base].entry);
+    	regions_[base].variables.push_back(number);
+    }
+    const vector<int>& rdefs = definitions.back().statements;
+    vector<int>& predecessors = dependences_[visiting_];
+    predecessors.insert(predecessors.end(), rdefs.begin(), rdefs.end());
 }
 
 void DependenceGraphBuilder::Write(Variable* var) {
-    region_->Define(var, visiting_);
+    const int number = Number(var);
+    const int depth = regions_.size() - 1;
+    vector<Definitions>& definitions = definitions_[number];
+    if (definitions.empty() || definitions.back().depth != depth) {
+    	definitions.push_back(Definitions());
+    	definitions.back().depth = depth;
+    	regions_.back().variables.push_back(number);
+    }
+    definitions.back().statements.assign(1, visiting_);
+}
+
+int DependenceGraphBuilder::Number(Variable* var) {
+    pair<map<Variable*,int>::iterator,bool> inserted = variables_.insert(make_pair(var, static_cast<int>(definitions_.size())));
+    if (inserted.second)
+    	definitions_.push_back(vector<Definitions>());
+    return inserted.first->second;
+}
+
+// A function region hides the definitions of the regions around it.
+void DependenceGraphBuilder::EnterRegion(int entry, bool function) {
+    Region region;
+    region.entry = entry;
+    region.base = function ? regions_.size() : regions_.back().base;
+    regions_.push_back(region);
+}
+
+// Leaves the innermost region, moving the definitions made in it into
+// defined, by variable number, unless it is NULL.
+void DependenceGraphBuilder::LeaveRegion(vector<pair<int,vector<int> > >* defined) {
+    const vector<int>& variables = regions_.back().variables;
+    for (vector<int>::const_iterator i = variables.begin(); i != variables.end(); ++i) {
+    	vector<Definitions>& definitions = definitions_[*i];
+    	if (defined) {
+    	    defined->push_back(make_pair(*i, vector<int>()));
+    	    defined->back().second.swap(definitions.back().statements);
+    	}
+    	definitions.pop_back();
+    }
+    regions_.pop_back();
+}
+
+// Adds definitions made in an inner region to the ones of the current region.
+// A variable not defined in the current region itself gets just these, which
+// then hide the definitions of the regions around it.
+void DependenceGraphBuilder::MergeDefinitions(const vector<pair<int,vector<int> > >& defined) {
+    const int depth = regions_.size() - 1;
+    for (vector<pair<int,vector<int> > >::const_iterator i = defined.begin(); i != defined.end(); ++i) {
+    	vector<Definitions>& definitions = definitions_[i->first];
+    	if (definitions.empty() || definitions.back().depth != depth) {
+    	    definitions.push_back(Definitions());
+    	    definitions.back().depth = depth;
+    	    regions_.back().variables.push_back(i->first);
+    	}
+    	definitions.back().statements.insert(definitions.back().statements.end(), i->second.begin(), i->second.end());
+    }
 }
 
-DependenceGraphBuilder::Region::Region(Region* outer_region, Statement* entry) : outer_region_(outer_region), entry_(entry) {
-}
+// class DependenceGraph
 
-DependenceGraphBuilder::Region::~Region() {
-    if (outer_region_ != NULL)
-	for (map<Variable*,list<Statement*> >::iterator iter = defs_.begin(); iter != defs_.end(); ++iter)
-	    outer_region_->defs_[iter->first].insert(outer_region_->defs_[iter->first].end(), iter->second.begin(), iter->second.end());
+int DependenceGraph::id(Statement* node) const {
+    unordered_map<Statement*,int>::const_iterator i = ids_.find(node);
+    return i != ids_.end() ? i->second : -1;
 }
 
-pair<list<Statement*>::const_iterator,list<Statement*>::const_iterator> DependenceGraphBuilder::Region::Find(Variable* var) {
-    if (defs_.find(var) != defs_.end())
-	return make_pair(defs_[var].begin(), defs_[var].end());
-    if (outer_region_ != NULL)
-	return outer_region_->Find(var);
-    Define(var, entry_);
-    return make_pair(defs_[var].begin(), defs_[var].end());
-}
+// class NeighborhoodGrower
 
-void DependenceGraphBuilder::Region::Define(Variable* var, Statement* stmt) {
-    defs_[var].clear();
-    defs_[var].push_back(stmt);
+NeighborhoodGrower::NeighborhoodGrower(const DependenceGraph& graph)
+    : graph_(graph), node_(-1), radius_(0), slots_(graph.size()), stamps_(graph.size(), 0), stamp_(0), next_(0),
+      remaining_(0), depth_(0) {
 }
 
-// class DependenceGraph
-
-const DependenceGraph DependenceGraph::GetNeighborhood(Statement* node, int radius) const {
-    queue<Statement*> q;
-    DependenceGraph neighborhood;
-    neighborhood.insert(make_pair(node, list<Statement*>()));
-    q.push(node);
-    size_t r = 1;
-    int d = 1;
-    while (d < radius) {
-	node = q.front();
-	q.pop();
-	for (list<Statement*>::const_iterator i = at(node).begin(); i != at(node).end(); ++i) {
-	    if (neighborhood.insert(make_pair(*i, list<Statement*>())).second)
-		q.push(*i);
-	    neighborhood[node].push_back(*i);
+void NeighborhoodGrower::Reset(int node) {
+    if (++stamp_ == 0) {
+    	// every stamp so far is stale once the counter wraps around
+    	stamps_.assign(stamps_.size(), 0);
+    	stamp_ = 1;
+    }
+    members_.clear();
+    edges_.clear();
+    node_ = node;
+    radius_ = 1;
+    stamps_[node] = stamp_;
+    slots_[node] = 0;
+    members_.push_back(node);
+    next_ = 0;
+    remaining_ = 1;
+    depth_ = 1;
+}
+
+bool NeighborhoodGrower::Grow(int radius) {
+    bool grown = false;
+    radius_ = radius;
+    while (depth_ < radius && next_ < members_.size()) {
+	Edge edge;
+	edge.from = next_;
+	DependenceGraph::Ids predecessors = graph_.predecessors(members_[next_++]);
+	for (DependenceGraph::Ids::const_iterator i = predecessors.begin(); i != predecessors.end(); ++i) {
+	    if (stamps_[*i] != stamp_) {
+		stamps_[*i] = stamp_;
+		slots_[*i] = members_.size();
+		members_.push_back(*i);
+	    }
+	    edge.to = slots_[*i];
+	    edges_.push_back(edge);
+	    grown = true;
 	}
-	if (q.empty())
+	if (next_ == members_.size())
 	    break;
-	if (--r == 0) {
-	    ++d;
-	    r = q.size();
+	if (--remaining_ == 0) {
+	    ++depth_;
+	    remaining_ = members_.size() - next_;
 	}
     }
-    return neighborhood;
+    return grown;
 }
@@ -18,25 +18,135 @@
 #ifndef DEPENDENCEGRAPHBUILDER_H
 #define DEPENDENCEGRAPHBUILDER_H
 
-#include <list>
 #include <map>
+#include <string>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 #include "CanonicalAst.h"
 
-using std::list;
 using std::map;
 using std::pair;
+using std::string;
+using std::unordered_map;
+using std::vector;
 
-class DependenceGraph : public map<Statement*,list<Statement*> > {
+// Every statement of a program gets a dense id, from 0 to size() - 1, in the
+// order the builder reaches it, which is done once after canonicalization.
+// The later stages keep whatever they know about a statement in vectors
+// indexed by its id rather than in maps keyed by the statement. The graph is
+// immutable once built, and its dependences are kept in compressed sparse row
+// form: the ids of the predecessors of all the statements in one array, those
+// of a statement being a run of it delimited by offsets, and likewise for the
+// successors.
+class DependenceGraph {
     public:
-	const DependenceGraph GetNeighborhood(Statement* node, int radius) const;
+	// A run of ids in one of the arrays of the graph.
+	class Ids {
+	    public:
+		typedef const int* const_iterator;
+
+		Ids(const int* begin, const int* end) : begin_(begin), end_(end) { }
+
+		inline const_iterator begin() const { return begin_; }
+		inline const_iterator end() const { return end_; }
+		inline size_t size() const { return end_ - begin_; }
+		inline bool empty() const { return begin_ == end_; }
+
+	    private:
+		const int* begin_;
+		const int* end_;
+	};
+
+	inline int size() const { return statements_.size(); }
+	// NULL for a graph loaded from a GraphFile, which has no AST.
+	inline Statement* statement(int id) const { return statements_[id]; }
+	// The node type of a statement, kept apart so that a loaded graph has it.
+	inline int type(int id) const { return types_[id]; }
+	// The serialization of a statement by OperationPrinter, done once by
+	// the builder so that the extractors never look into the AST for it.
+	inline const string& op(int id) const { return ops_[id]; }
+	// Returns the id of a statement, or -1 if it is not in the graph. This
+	// takes a hash lookup, so it is meant for the boundaries with the AST.
+	int id(Statement* node) const;
+	// The ids of the statements a statement depends on, and of the ones
+	// depending on it, in increasing order.
+	inline Ids predecessors(int id) const {
+	    return Ids(predecessors_.data() + predecessor_offsets_[id], predecessors_.data() + predecessor_offsets_[id + 1]);
+	}
+	inline Ids successors(int id) const {
+	    return Ids(successors_.data() + successor_offsets_[id], successors_.data() + successor_offsets_[id + 1]);
+	}
+
+    private:
+	friend class DependenceGraphBuilder;
+	friend class GraphFile;
+
+	vector<Statement*> statements_;
+	vector<int> types_;
+	vector<string> ops_;
+	unordered_map<Statement*,int> ids_;  // filled as the ids are given
+	vector<int> predecessor_offsets_;  // by id, and one past the last id
+	vector<int> predecessors_;
+	vector<int> successor_offsets_;
+	vector<int> successors_;
+};
+
+// The breadth-first search collecting the neighborhood of a statement, which
+// can be resumed to grow the neighborhood to a larger radius without
+// revisiting the inner levels, and reset to start over from another statement
+// without reallocating. Membership is kept by stamping the statements with
+// the number of the search, so a reset takes constant time, and the induced
+// subgraph is collected as an edge list while growing.
+class NeighborhoodGrower {
+    public:
+	// A dependence between two members, given by their positions.
+	struct Edge {
+	    int from;  // the dependent statement
+	    int to;  // the statement it depends on
+	};
+
+	explicit NeighborhoodGrower(const DependenceGraph& graph);
+
+	// Starts over from the given statement at radius 1.
+	void Reset(int node);
+
+	// Grows the neighborhood to the given radius, which must not be smaller
+	// than the current one. Returns false if nothing was added.
+	bool Grow(int radius);
+
+	inline int node() const { return node_; }
+	inline int radius() const { return radius_; }
+
+	// The statements of the neighborhood in the order they were reached, the
+	// starting one first. The dependences of the first num_expanded() of them
+	// are in the neighborhood; the ones of the rest are not.
+	inline const vector<int>& members() const { return members_; }
+	inline size_t num_expanded() const { return next_; }
+	// Returns the position of a statement in members(), or -1.
+	inline int slot(int id) const { return stamps_[id] == stamp_ ? slots_[id] : -1; }
+	// The dependences of the expanded members on the others, ordered by
+	// dependent member and then by the id of the statement depended on.
+	inline const vector<Edge>& edges() const { return edges_; }
+
+    private:
+	const DependenceGraph& graph_;
+	int node_;
+	int radius_;
+	vector<int> members_;  // also the queue of the search, from next_ on
+	vector<int> slots_;  // by id, valid where stamped with stamp_
+	vector<unsigned> stamps_;  // by id
+	unsigned stamp_;
+	vector<Edge> edges_;
+	size_t next_;
+	size_t remaining_;  // nodes left to expand at the current depth
+	int depth_;
 };
 
 class DependenceGraphBuilder : public CanonicalAstVisitor {
     public:
 	void Build(FunctionLiteral* program);
 	inline const DependenceGraph& GetGraph() const { return graph_; }
-	inline const list<Statement*>& GetSuccessors(Statement* node) const { return reverse_graph_.at(node); }
 
 #define DECLARE_VISIT(type) \
 	void Visit##type(type* node);
@@ -45,30 +155,37 @@ class DependenceGraphBuilder : public CanonicalAstVisitor {
 #undef DECLARE_VISIT
 
     private:
-	class Region {
-	    public:
-		Region(Region* outer_region, Statement* entry);
-		~Region();
-
-		inline Statement* entry() const { return entry_; }
-		inline Region* outer_region() const { return outer_region_; }
-		pair<list<Statement*>::const_iterator,list<Statement*>::const_iterator> Find(Variable* var);
-		void Define(Variable* var, Statement* stmt);
+	// The definitions of a variable that reach the statement being visited
+	// from one region: a function body, or a branch or loop body in it.
+	struct Definitions {
+	    int depth;  // of the region
+	    vector<int> statements;  // ids
+	};
 
-	    private:
-		Region* outer_region_;
-		Statement* entry_;
-		map<Variable*,list<Statement*> > defs_;
+	struct Region {
+	    int entry;  // id of the statement the region depends on
+	    int base;  // depth of the region of the function
+	    vector<int> variables;  // numbers of the ones defined in the region
 	};
 
-	Statement* visiting_;
-	Region* region_;
+	int visiting_;  // id of the statement being visited
 	DependenceGraph graph_;
-	DependenceGraph reverse_graph_;
+	vector<vector<int> > dependences_;  // predecessors by id, until they are packed into graph_
+	// Every variable gets a dense number the first time it is seen, and a
+	// stack of definitions, one for every region it was defined in, the
+	// innermost last. Finding the reaching definitions only looks at the top,
+	// and leaving a region only touches the variables defined in it.
+	map<Variable*,int> variables_;
+	vector<vector<Definitions> > definitions_;  // by number
+	vector<Region> regions_;  // the innermost last
 
 	void VisitStatements(ZoneList<Statement*>* stmts);
 	void Read(Variable* var);
 	void Write(Variable* var);
+	int Number(Variable* var);
+	void EnterRegion(int entry, bool function);
+	void LeaveRegion(vector<pair<int,vector<int> > >* defined);
+	void MergeDefinitions(const vector<pair<int,vector<int> > >& defined);
 };
 
 #endif  // DEPENDENCEGRAPHBUILDER_H
@@ -0,0 +1,71 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#include "ExtractorPool.h"
+
+#include <pthread.h>
+
+ExtractorPool::ExtractorPool(const vector<NgramExtractor*>& extractors) : workers_(extractors.size()) {
+    for (size_t i = 0; i < extractors.size(); ++i) {
+        workers_[i].pool = this;
+        workers_[i].extractor = extractors[i];
+    }
+}
+
+void ExtractorPool::Run(const vector<int>& nodes, int n, int max_n, vector<Ngram>* ngrams) {
+    nodes_ = &nodes;
+    n_ = n;
+    max_n_ = max_n;
+    ngrams_ = ngrams;
+    ngrams->assign(nodes.size() * (max_n - n + 1), Ngram());
+    next_ = 0;
+    size_t num_threads = 1;
+    while (num_threads < workers_.size() && num_threads * kMinNodesPerThread < nodes.size())
+        ++num_threads;
+    // statements are claimed one at a time, so a thread that cannot be
+    // started only leaves more of them to the others
+    vector<pthread_t> threads;
+    for (size_t i = 1; i < num_threads; ++i) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, &ExtractorPool::Work, &workers_[i]) == 0)
+            threads.push_back(thread);
+    }
+    Extract(workers_[0].extractor);
+    for (size_t i = 0; i < threads.size(); ++i)
+        pthread_join(threads[i], NULL);
+}
+
+void* ExtractorPool::Work(void* worker) {
+    Worker* self = static_cast<Worker*>(worker);
+    self->pool->Extract(self->extractor);
+    return NULL;
+}
+
+void ExtractorPool::Extract(NgramExtractor* extractor) {
+    const size_t depths = max_n_ - n_ + 1;
+    size_t i;
+    while ((i = __sync_fetch_and_add(&next_, 1)) < nodes_->size()) {
+        // all the radii of a statement in a row, so that its neighborhood is grown incrementally
+        for (int k = n_; k <= max_n_; ++k) {
+            Ngram& ngram = (*ngrams_)[i * depths + k - n_];
+            extractor->Extract((*nodes_)[i], k, true, &ngram);
+            // skipped statements are reported with their status in place of the n-gram
+            if (ngram.pattern == "")
+                ngram.pattern = NgramExtractor::StatusName(extractor->status());
+        }
+    }
+}
@@ -0,0 +1,67 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#ifndef EXTRACTORPOOL_H
+#define EXTRACTORPOOL_H
+
+#include <string>
+#include <vector>
+#include "Ngram.h"
+#include "NgramExtractor.h"
+
+using std::string;
+using std::vector;
+
+// Extracts the n-grams of the statements of one script with a number of
+// threads, each of which owns an extractor over the same dependence graph.
+// Threads claim the statements one at a time, so that one stuck on a costly
+// neighborhood does not hold the others back, and the n-grams are stored by
+// position, so that they come out in the order of the statements.
+class ExtractorPool {
+    public:
+        // There is a thread for every extractor, the calling one running the
+        // first. The extractors must not share any state but the graph and a
+        // StructureCache.
+        explicit ExtractorPool(const vector<NgramExtractor*>& extractors);
+
+        // Extracts the n-grams of depths n to max_n of every node, with their
+        // long descriptions, into ngrams, the ones of a node in a row. A
+        // skipped n-gram is given by the name of its status.
+        void Run(const vector<int>& nodes, int n, int max_n, vector<Ngram>* ngrams);
+
+    private:
+        struct Worker {
+            ExtractorPool* pool;
+            NgramExtractor* extractor;
+        };
+
+        // Scripts with fewer statements per thread than this are not worth
+        // starting the threads for.
+        static const size_t kMinNodesPerThread = 64;
+
+        vector<Worker> workers_;
+        const vector<int>* nodes_;
+        int n_;
+        int max_n_;
+        vector<Ngram>* ngrams_;
+        size_t next_;  // the next node to be claimed
+
+        static void* Work(void* worker);
+        void Extract(NgramExtractor* extractor);
+};
+
+#endif // EXTRACTORPOOL_H
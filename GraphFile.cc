@@ -0,0 +1,218 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#include "GraphFile.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "CodePrinter.h"
+#include "Hash.h"
+
+static const char kMagic[8] = {'J', 'S', 'G', 'R', 'A', 'P', 'H', '1'};
+
+namespace {
+
+struct Header {
+    char magic[8];
+    int32_t size;
+    int32_t num_dependences;
+    int32_t ops_length;
+    int32_t path_length;
+};
+
+// Reads the arrays of a file in order, failing once they run past its end.
+class ArrayReader {
+    public:
+        ArrayReader(const char* data, size_t length) : data_(data), end_(data + length) { }
+
+        bool Read(size_t count, vector<int>* values) {
+            if (static_cast<size_t>(end_ - data_) / sizeof(int32_t) < count)
+                return false;
+            values->resize(count);
+            // int is 32 bits wherever V8 builds
+            if (count)
+                memcpy(&(*values)[0], data_, count * sizeof(int32_t));
+            data_ += count * sizeof(int32_t);
+            return true;
+        }
+
+        bool Read(size_t length, string* bytes) {
+            if (static_cast<size_t>(end_ - data_) < length)
+                return false;
+            bytes->assign(data_, length);
+            data_ += length;
+            return true;
+        }
+
+        inline bool AtEnd() const { return data_ == end_; }
+
+    private:
+        const char* data_;
+        const char* end_;
+};
+
+}
+
+static inline void AppendInts(string* s, const vector<int>& values) {
+    if (!values.empty())
+        s->append(reinterpret_cast<const char*>(&values[0]), values.size() * sizeof(int32_t));
+}
+
+// Checks that offsets delimit runs of an array of the given length in order,
+// and that the values in it are ids of a graph of the given size.
+static bool IsValid(const vector<int>& offsets, const vector<int>& values, int size) {
+    if (offsets[0] != 0 || static_cast<size_t>(offsets.back()) != values.size())
+        return false;
+    for (size_t i = 1; i < offsets.size(); ++i) {
+        if (offsets[i] < offsets[i - 1])
+            return false;
+    }
+    for (vector<int>::const_iterator i = values.begin(); i != values.end(); ++i) {
+        if (*i < 0 || *i >= size)
+            return false;
+    }
+    return true;
+}
+
+GraphFile::GraphFile(const DependenceGraph& graph, const CodePrinter& printer)
+    : graph_(&graph), lines_(printer.NumLines()), linenos_(graph.size()), funcnos_(graph.size()) {
+    for (size_t i = 1; i <= lines_.size(); ++i)
+        lines_[i - 1] = printer.GetLine(i);
+    for (int i = 0; i < graph.size(); ++i) {
+        linenos_[i] = printer.GetLineNo(i);
+        funcnos_[i] = printer.GetFuncNo(i);
+    }
+}
+
+GraphFile* GraphFile::Load(const char* data, size_t length) {
+    Header header;
+    if (length < sizeof(header))
+        return NULL;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.size < 0 || header.num_dependences < 0 ||
+        header.ops_length < 0 || header.path_length < 0)
+        return NULL;
+    const size_t size = header.size;
+    const size_t num_dependences = header.num_dependences;
+
+    GraphFile* file = new GraphFile();
+    DependenceGraph& graph = file->loaded_;
+    ArrayReader reader(data + sizeof(header), length - sizeof(header));
+    vector<int> op_offsets;
+    string ops;
+    if (!reader.Read(size, &graph.types_) || !reader.Read(size, &file->linenos_) || !reader.Read(size, &file->funcnos_) ||
+        !reader.Read(size + 1, &op_offsets) || !reader.Read(size + 1, &graph.predecessor_offsets_) ||
+        !reader.Read(num_dependences, &graph.predecessors_) || !reader.Read(size + 1, &graph.successor_offsets_) ||
+        !reader.Read(num_dependences, &graph.successors_) || !reader.Read(header.ops_length, &ops) ||
+        !reader.Read(header.path_length, &file->path_) || !reader.AtEnd() ||
+        !IsValid(graph.predecessor_offsets_, graph.predecessors_, size) ||
+        !IsValid(graph.successor_offsets_, graph.successors_, size) ||
+        op_offsets[0] != 0 || static_cast<size_t>(op_offsets.back()) != ops.size()) {
+        delete file;
+        return NULL;
+    }
+
+    graph.statements_.assign(size, NULL);
+    graph.ops_.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+        if (op_offsets[i + 1] < op_offsets[i]) {
+            delete file;
+            return NULL;
+        }
+        graph.ops_[i].assign(ops, op_offsets[i], op_offsets[i + 1] - op_offsets[i]);
+    }
+    // the lines are numbered from 1 without gaps
+    for (size_t i = 0; i < size; ++i) {
+        int lineno = file->linenos_[i];
+        if (lineno < 0 || static_cast<size_t>(lineno) > size) {
+            delete file;
+            return NULL;
+        }
+        if (static_cast<size_t>(lineno) > file->lines_.size())
+            file->lines_.resize(lineno, -1);
+        if (lineno)
+            file->lines_[lineno - 1] = i;
+    }
+    for (vector<int>::iterator i = file->lines_.begin(); i != file->lines_.end(); ++i) {
+        if (*i < 0) {
+            delete file;
+            return NULL;
+        }
+    }
+    return file;
+}
+
+bool GraphFile::Save(const string& dir, const string& path) const {
+    const DependenceGraph& graph = *graph_;
+    const int size = graph.size();
+    Header header;
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.size = size;
+    header.num_dependences = graph.predecessors_.size();
+    header.path_length = path.size();
+    vector<int> op_offsets(1, 0);
+    string ops;
+    for (int i = 0; i < size; ++i) {
+        ops += graph.op(i);
+        op_offsets.push_back(ops.size());
+    }
+    header.ops_length = ops.size();
+
+    string data(reinterpret_cast<const char*>(&header), sizeof(header));
+    AppendInts(&data, graph.types_);
+    AppendInts(&data, linenos_);
+    AppendInts(&data, funcnos_);
+    AppendInts(&data, op_offsets);
+    AppendInts(&data, graph.predecessor_offsets_);
+    AppendInts(&data, graph.predecessors_);
+    AppendInts(&data, graph.successor_offsets_);
+    AppendInts(&data, graph.successors_);
+    data += ops;
+    data += path;
+
+    // laid out like a ScriptCache, but keyed by the path
+    string hex = Hash128(path.data(), path.size()).ToHex();
+    string subdir = dir + '/' + hex.substr(0, 2);
+    mkdir(dir.c_str(), 0777);
+    mkdir(subdir.c_str(), 0777);
+    string file = subdir + '/' + hex.substr(2);
+    string temp = file + ".XXXXXX";
+    int fd = mkstemp(&temp[0]);
+    if (fd < 0)
+        return false;
+    const char* ptr = data.data();
+    size_t remaining = data.size();
+    while (remaining > 0) {
+        ssize_t n = write(fd, ptr, remaining);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        ptr += n;
+        remaining -= n;
+    }
+    if (close(fd) == 0 && remaining == 0 && rename(temp.c_str(), file.c_str()) == 0)
+        return true;
+    unlink(temp.c_str());
+    return false;
+}
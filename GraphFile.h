@@ -0,0 +1,77 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#ifndef GRAPHFILE_H
+#define GRAPHFILE_H
+
+#include <string>
+#include <vector>
+#include "DependenceGraph.h"
+
+using std::string;
+using std::vector;
+
+class CodePrinter;
+
+// The dependence graph of a script with everything the extractors need from
+// the printer: the line and function numbers of the statements, the lines
+// also giving their lexical order. It can be saved to a file and loaded back,
+// so that the extraction can be run again without parsing the script.
+//
+// The file is a header followed by arrays of native 32-bit integers at fixed
+// offsets, all indexed by id, and then the bytes of the ops and of the path of
+// the script:
+//
+//   "JSGRAPH1", size, number of dependences, bytes of ops, bytes of path
+//   types[size], line numbers[size], function numbers[size],
+//   op offsets[size + 1], predecessor offsets[size + 1], predecessors[deps],
+//   successor offsets[size + 1], successors[deps], ops, path
+//
+// so a mapped file is read with one copy per array and no parsing.
+class GraphFile {
+    public:
+        // The graph of a script just parsed, which must outlive this.
+        GraphFile(const DependenceGraph& graph, const CodePrinter& printer);
+
+        // Returns NULL if data does not hold a valid graph file. Nothing
+        // points into data afterwards.
+        static GraphFile* Load(const char* data, size_t length);
+        // Saves the graph of the script at path into dir, as the file named
+        // by the hash of path. Returns false if the file cannot be written.
+        bool Save(const string& dir, const string& path) const;
+
+        // The path of the script, for a loaded graph only.
+        inline const string& path() const { return path_; }
+        inline const DependenceGraph& graph() const { return *graph_; }
+        inline size_t NumLines() const { return lines_.size(); }
+        // Statements are given and returned as ids, as with CodePrinter.
+        inline int GetLine(int lineno) const { return lines_.at(lineno - 1); }
+        inline int GetFuncNo(int node) const { return funcnos_[node]; }
+        inline int CompareNode(const int& x, const int& y) const { return linenos_[x] - linenos_[y]; }
+
+    private:
+        GraphFile() : graph_(&loaded_) { }
+
+        const DependenceGraph* graph_;
+        DependenceGraph loaded_;  // the graph, if loaded
+        string path_;
+        vector<int> lines_;  // ids by line
+        vector<int> linenos_;  // by id, 0 if not printed
+        vector<int> funcnos_;  // by id
+};
+
+#endif // GRAPHFILE_H
@@ -0,0 +1,88 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#include "Hash.h"
+
+#include <string.h>
+
+static inline uint64_t Rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t Mix(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+Hash128::Hash128(const void* data, size_t size, uint64_t seed) : h1(seed), h2(seed) {
+    const uint64_t c1 = 0x87c37b91114253d5ULL;
+    const uint64_t c2 = 0x4cf5ad432745937fULL;
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    const size_t num_blocks = size / 16;
+
+    for (size_t i = 0; i < num_blocks; ++i) {
+        uint64_t k1;
+        uint64_t k2;
+        memcpy(&k1, bytes + i * 16, 8);
+        memcpy(&k2, bytes + i * 16 + 8, 8);
+        k1 *= c1; k1 = Rotl(k1, 31); k1 *= c2; h1 ^= k1;
+        h1 = Rotl(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+        k2 *= c2; k2 = Rotl(k2, 33); k2 *= c1; h2 ^= k2;
+        h2 = Rotl(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    const unsigned char* tail = bytes + num_blocks * 16;
+    uint64_t k1 = 0;
+    uint64_t k2 = 0;
+    // the tail is read as two little-endian words, as in the reference code
+    size_t rest = size & 15;
+    for (size_t i = rest; i > 8; --i)
+        k2 ^= uint64_t(tail[i - 1]) << ((i - 9) * 8);
+    if (rest > 8) {
+        k2 *= c2; k2 = Rotl(k2, 33); k2 *= c1; h2 ^= k2;
+    }
+    for (size_t i = rest < 8 ? rest : 8; i > 0; --i)
+        k1 ^= uint64_t(tail[i - 1]) << ((i - 1) * 8);
+    if (rest > 0) {
+        k1 *= c1; k1 = Rotl(k1, 31); k1 *= c2; h1 ^= k1;
+    }
+
+    h1 ^= size;
+    h2 ^= size;
+    h1 += h2;
+    h2 += h1;
+    h1 = Mix(h1);
+    h2 = Mix(h2);
+    h1 += h2;
+    h2 += h1;
+}
+
+string Hash128::ToHex() const {
+    static const char digits[] = "0123456789abcdef";
+    char hex[32];
+    for (int i = 0; i < 16; ++i) {
+        uint64_t h = i < 8 ? h1 : h2;
+        int byte = (h >> (56 - 8 * (i % 8))) & 0xff;
+        hex[2 * i] = digits[byte >> 4];
+        hex[2 * i + 1] = digits[byte & 15];
+    }
+    return string(hex, sizeof(hex));
+}
@@ -0,0 +1,44 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#ifndef HASH_H
+#define HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+using std::string;
+
+// A 128-bit content hash (MurmurHash3, x64 variant). It is not
+// cryptographic, but collisions between distinct scripts are not a concern
+// at our scale.
+struct Hash128 {
+    uint64_t h1;
+    uint64_t h2;
+
+    Hash128() : h1(0), h2(0) { }
+    Hash128(const void* data, size_t size, uint64_t seed = 0);
+
+    // 32 lowercase hex digits
+    string ToHex() const;
+
+    inline bool operator== (const Hash128& other) const { return h1 == other.h1 && h2 == other.h2; }
+    inline bool operator< (const Hash128& other) const { return h1 < other.h1 || (h1 == other.h1 && h2 < other.h2); }
+};
+
+#endif // HASH_H
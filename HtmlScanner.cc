@@ -0,0 +1,104 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#include "HtmlScanner.h"
+
+#include <ctype.h>
+#include <strings.h>
+
+static const char kBlanks[] = " \t\n\v\f\r";
+
+static inline bool StartsWith(const string& html, size_t pos, const char* prefix, size_t size) {
+    return html.size() - pos >= size && strncasecmp(html.c_str() + pos, prefix, size) == 0;
+}
+
+void HtmlScanner::Scan(const string& html, vector<Script>* scripts) {
+    scripts->clear();
+    int line = 1;
+    size_t line_start = 0;
+    size_t counted = 0;  // newlines before this position are counted
+    for (size_t pos = html.find('<'); pos != string::npos; pos = html.find('<', pos)) {
+        if (StartsWith(html, pos, "<!--", 4)) {
+            pos = html.find("-->", pos + 4);
+            if (pos == string::npos)
+                break;
+            pos += 3;
+            continue;
+        }
+        if (!StartsWith(html, pos, "<script", 7) || (pos + 7 < html.size() && isalnum(html[pos + 7]))) {
+            ++pos;
+            continue;
+        }
+        size_t body = FindTagEnd(html, pos);
+        if (body == string::npos)
+            break;
+        size_t end = body;
+        while ((end = html.find('<', end)) != string::npos && !StartsWith(html, end, "</script", 8))
+            ++end;
+        if (end == string::npos)
+            end = html.size();
+
+        for (; counted < pos; ++counted) {
+            if (html[counted] == '\n') {
+                ++line;
+                line_start = counted + 1;
+            }
+        }
+        Script script;
+        script.line = line;
+        script.column = pos - line_start;
+        script.code.assign(html, body, end - body);
+        Strip(&script.code);
+        if (!script.code.empty())
+            scripts->push_back(script);
+        pos = end;
+    }
+}
+
+// Returns the position right after the '>' closing the tag at pos.
+size_t HtmlScanner::FindTagEnd(const string& html, size_t pos) {
+    char quote = '\0';
+    for (; pos < html.size(); ++pos) {
+        if (quote) {
+            if (html[pos] == quote)
+                quote = '\0';
+        } else if (html[pos] == '"' || html[pos] == '\'') {
+            quote = html[pos];
+        } else if (html[pos] == '>') {
+            return pos + 1;
+        }
+    }
+    return string::npos;
+}
+
+void HtmlScanner::Strip(string* code) {
+    for (int pass = 0; pass < 2; ++pass) {
+        size_t begin = code->find_first_not_of(kBlanks);
+        if (begin == string::npos) {
+            code->clear();
+            return;
+        }
+        code->erase(0, begin);
+        code->erase(code->find_last_not_of(kBlanks) + 1);
+        if (pass == 0 && code->size() >= 7 && code->compare(0, 4, "<!--") == 0 &&
+            code->compare(code->size() - 3, 3, "-->") == 0) {
+            *code = code->substr(4, code->size() - 7);
+        } else {
+            return;
+        }
+    }
+}
@@ -0,0 +1,46 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#ifndef HTMLSCANNER_H
+#define HTMLSCANNER_H
+
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+// Finds the inline scripts of an HTML page the way scripts/extract_js.py
+// does: the contents of <script> elements, stripped of surrounding blanks and
+// of a wrapping <!-- -->, with empty ones dropped. External scripts (src=) are
+// not fetched.
+class HtmlScanner {
+    public:
+        struct Script {
+            int line;  // of the <script> tag, from 1
+            int column;  // from 0
+            string code;
+        };
+
+        static void Scan(const string& html, vector<Script>* scripts);
+
+    private:
+        static size_t FindTagEnd(const string& html, size_t pos);
+        static void Strip(string* code);
+};
+
+#endif // HTMLSCANNER_H
@@ -0,0 +1,92 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#include "MappedScript.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+MappedScript* MappedScript::Open(const string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return NULL;
+    }
+    // mmap() refuses empty mappings
+    if (st.st_size == 0) {
+        close(fd);
+        return new MappedScript("", 0);
+    }
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return NULL;
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+    return new MappedScript(static_cast<const char*>(data), st.st_size);
+}
+
+MappedScript::~MappedScript() {
+    if (external_)
+        v8::V8::AdjustAmountOfExternalAllocatedMemory(-static_cast<intptr_t>(length_));
+    if (length_ > 0)
+        munmap(const_cast<char*>(data_), length_);
+}
+
+v8::Local<v8::String> MappedScript::ToString(MappedScript* script) {
+    if (IsAscii(script->data(), script->length())) {
+        script->external_ = true;
+        v8::V8::AdjustAmountOfExternalAllocatedMemory(script->length_);
+        return v8::String::NewExternal(script);
+    }
+    v8::Local<v8::String> source = v8::String::New(script->data(), static_cast<int>(script->length()));
+    delete script;
+    return source;
+}
+
+bool MappedScript::IsAscii(const char* data, size_t length) {
+    const char* end = data + length;
+#ifdef __SSE2__
+    // OR 64 bytes at a time and test all the sign bits at once
+    for (; data + 64 <= end; data += 64) {
+        __m128i x = _mm_or_si128(_mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)),
+                                              _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16))),
+                                 _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 32)),
+                                              _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 48))));
+        if (_mm_movemask_epi8(x))
+            return false;
+    }
+#endif
+    uint64_t bits = 0;
+    for (; data + 8 <= end; data += 8) {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        bits |= word;
+    }
+    for (; data < end; ++data)
+        bits |= static_cast<unsigned char>(*data);
+    return !(bits & 0x8080808080808080ULL);
+}
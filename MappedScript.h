@@ -0,0 +1,57 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#ifndef MAPPEDSCRIPT_H
+#define MAPPEDSCRIPT_H
+
+#include <string>
+#include <v8.h>
+
+using std::string;
+
+// A read-only memory mapping of a script file. It can be handed to V8 as the
+// resource of an external one-byte string, in which case V8 owns it and the
+// file stays mapped until the string is garbage collected. The mapping is
+// then reported to V8 as external memory, so that the strings of scripts long
+// done are collected before the mappings pile up; the AST of a script lives in
+// the zone, which leaves V8 no other reason to collect the heap.
+class MappedScript : public v8::String::ExternalAsciiStringResource {
+    public:
+        // Returns NULL if the file cannot be mapped.
+        static MappedScript* Open(const string& path);
+        virtual ~MappedScript();
+
+        virtual const char* data() const { return data_; }
+        virtual size_t length() const { return length_; }
+
+        // Returns a V8 string of the script. An ASCII script becomes an
+        // external string backed by the mapping, and V8 takes the ownership of
+        // the MappedScript; any other script is decoded from UTF-8 into a new
+        // string, and the MappedScript is deleted right away.
+        static v8::Local<v8::String> ToString(MappedScript* script);
+
+        static bool IsAscii(const char* data, size_t length);
+
+    private:
+        MappedScript(const char* data, size_t length) : data_(data), length_(length), external_(false) { }
+
+        const char* data_;
+        size_t length_;
+        bool external_;  // reported to V8 as external memory
+};
+
+#endif // MAPPEDSCRIPT_H
@@ -0,0 +1,51 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#ifndef NGRAM_H
+#define NGRAM_H
+
+#include <sstream>
+#include <string>
+
+using std::ostringstream;
+using std::string;
+
+// An n-gram of a statement, and the long description of the statement if it
+// was asked for: the number of statements of its neighborhood, its op, and
+// the pattern of its neighborhood without it. The pattern of a skipped
+// statement is empty, or the name of its status once written out; its long
+// description has only the op, with a size of 0.
+struct Ngram {
+    string pattern;
+    size_t size;  // 0 without a long description or for a skipped statement
+    string op;
+    string context;
+
+    Ngram() : size(0) { }
+
+    // The fields of the long description follow the pattern, separated by
+    // tabs, as in the text format.
+    string ToString() const {
+        if (!size)
+            return pattern;
+        ostringstream out;
+        out << pattern << '\t' << size << '\t' << op << '\t' << context;
+        return out.str();
+    }
+};
+
+#endif // NGRAM_H
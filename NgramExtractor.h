@@ -21,7 +21,8 @@
 #include <map>
 #include <string>
 #include <vector>
-#include "OperationPrinter.h"
+#include "Ngram.h"
+#include "PatternDictionary.h"
 
 using std::map;
 using std::string;
@@ -29,15 +30,44 @@ using std::vector;
 
 class NgramExtractor {
     public:
+	// Why the last Extract() returned an empty n-gram, if it did.
+	enum Status {
+	    kExtracted,
+	    kTooLarge,  // the neighborhood exceeds the size limit
+	    kTooCostly,  // the estimated search cost exceeds the cost limit
+	    kOverBudget  // the search explored more orders than the budget
+	};
+
+	NgramExtractor() : status_(kExtracted), dictionary_(NULL) { }
         virtual ~NgramExtractor() { }
 
-	virtual string Extract(Statement* node, int n, bool long_desc = false) = 0;
+	// The node is given by its id in the dependence graph. The n-gram is
+	// left empty if the node is skipped.
+	virtual void Extract(int node, int n, bool long_desc, Ngram* ngram) = 0;
+	// The n-gram in the text format.
+	string Extract(int node, int n, bool long_desc = false) {
+	    Ngram ngram;
+	    Extract(node, n, long_desc, &ngram);
+	    return ngram.ToString();
+	}
+
+	inline Status status() const { return status_; }
+
+	// Makes Extract() return fingerprints of the patterns from dictionary
+	// instead of the patterns themselves.
+	inline void set_dictionary(PatternDictionary* dictionary) { dictionary_ = dictionary; }
+	static inline const char* StatusName(Status status) {
+	    static const char* const names[] = {"", "!size", "!cost", "!budget"};
+	    return names[status];
+	}
 
     protected:
-	inline string Serialize(Statement* node) { return serializer_.Print(node); }
+	Status status_;
+
+	inline string Output(const string& pattern) { return dictionary_ ? dictionary_->Fingerprint(pattern) : pattern; }
 
     private:
-	OperationPrinter serializer_;
+	PatternDictionary* dictionary_;
 };
 
 #endif // NGRAMEXTRACTOR_H
@@ -0,0 +1,181 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#include "NgramWriter.h"
+
+#include <cstdio>
+
+using std::istringstream;
+
+static const char kMagic[] = "JSGB";
+static const size_t kVersion = 4;
+
+static void WriteVarint(ostream* out, size_t value) {
+    char buf[10];
+    size_t size = 0;
+    for (; value >= 0x80; value >>= 7)
+        buf[size++] = static_cast<char>(value | 0x80);
+    buf[size++] = static_cast<char>(value);
+    out->write(buf, size);
+}
+
+static void WriteString(ostream* out, const string& value) {
+    WriteVarint(out, value.size());
+    out->write(value.data(), value.size());
+}
+
+void TextNgramWriter::BeginScript(const string& path) {
+    path_ = path;
+}
+
+void TextNgramWriter::Write(size_t line, int func, int n, const Ngram& ngram) {
+    if (tag_)
+        *out_ << path_ << '\t';
+    *out_ << ngram.pattern;
+    if (descriptions_)
+        *out_ << '\t' << ngram.size << '\t' << ngram.op << '\t' << ngram.context;
+    if (positions_)
+        *out_ << '\t' << line << '\t' << func;
+    if (radii_)
+        *out_ << '\t' << n;
+    *out_ << '\n';
+}
+
+void BinaryNgramWriter::WriteHeader(ostream* out, int flags) {
+    out->write(kMagic, sizeof(kMagic) - 1);
+    WriteVarint(out, kVersion);
+    WriteVarint(out, flags);
+}
+
+void BinaryNgramWriter::BeginScript(const string& path) {
+    out_->put(BinaryNgramReader::kScript);
+    WriteString(out_, path);
+}
+
+void BinaryNgramWriter::WriteFunction(int line, const string& signature) {
+    out_->put(BinaryNgramReader::kFunction);
+    WriteVarint(out_, line);
+    WriteString(out_, signature);
+}
+
+void BinaryNgramWriter::Write(size_t line, int func, int n, const Ngram& ngram) {
+    out_->put(BinaryNgramReader::kNgram);
+    WriteVarint(out_, line);
+    WriteVarint(out_, func);
+    WriteVarint(out_, n);
+    WriteString(out_, ngram.pattern);
+    WriteVarint(out_, ngram.size);
+    WriteString(out_, ngram.op);
+    WriteString(out_, ngram.context);
+}
+
+void RecordingNgramWriter::BeginScript(const string& path) {
+    writer_->BeginScript(path);
+    records_.str("");
+}
+
+void RecordingNgramWriter::WriteFunction(int line, const string& signature) {
+    if (writer_->WantsFunctions())
+        writer_->WriteFunction(line, signature);
+    recorder_.WriteFunction(line, signature);
+}
+
+void RecordingNgramWriter::Write(size_t line, int func, int n, const Ngram& ngram) {
+    writer_->Write(line, func, n, ngram);
+    recorder_.Write(line, func, n, ngram);
+}
+
+bool BinaryNgramReader::ReadHeader(int* flags) {
+    char magic[sizeof(kMagic) - 1];
+    if (!in_->read(magic, sizeof(magic)) || string(magic, sizeof(magic)) != kMagic)
+        return false;
+    size_t version;
+    size_t value;
+    if (!ReadVarint(&version) || version != kVersion || !ReadVarint(&value))
+        return false;
+    *flags = static_cast<int>(value);
+    return true;
+}
+
+bool BinaryNgramReader::Next(Record* record) {
+    int kind = in_->get();
+    size_t func = 0;
+    size_t n = 0;
+    switch (kind) {
+        case EOF:
+            return false;
+
+        case kScript:
+            record->kind = kScript;
+            malformed_ = !ReadString(&record->path);
+            break;
+
+        case kFunction:
+            record->kind = kFunction;
+            malformed_ = !ReadVarint(&record->line) || !ReadString(&record->signature);
+            break;
+
+        case kNgram:
+            record->kind = kNgram;
+            malformed_ = !ReadVarint(&record->line) || !ReadVarint(&func) || !ReadVarint(&n) ||
+                         !ReadString(&record->ngram.pattern) || !ReadVarint(&record->ngram.size) ||
+                         !ReadString(&record->ngram.op) || !ReadString(&record->ngram.context);
+            record->func = static_cast<int>(func);
+            record->n = static_cast<int>(n);
+            break;
+
+        default:
+            malformed_ = true;
+    }
+    return !malformed_;
+}
+
+bool BinaryNgramReader::Replay(const string& records, NgramWriter* writer) {
+    istringstream in(records);
+    BinaryNgramReader reader(&in);
+    Record record;
+    while (reader.Next(&record)) {
+        if (record.kind == kFunction) {
+            if (writer->WantsFunctions())
+                writer->WriteFunction(record.line, record.signature);
+        } else if (record.kind == kNgram) {
+            writer->Write(record.line, record.func, record.n, record.ngram);
+        }
+    }
+    return !reader.malformed();
+}
+
+bool BinaryNgramReader::ReadVarint(size_t* value) {
+    *value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = in_->get();
+        if (byte == EOF)
+            return false;
+        *value |= static_cast<size_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+bool BinaryNgramReader::ReadString(string* value) {
+    size_t size;
+    if (!ReadVarint(&size))
+        return false;
+    value->resize(size);
+    return size == 0 || in_->read(&(*value)[0], size);
+}
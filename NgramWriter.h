@@ -0,0 +1,164 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#ifndef NGRAMWRITER_H
+#define NGRAMWRITER_H
+
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include "Ngram.h"
+
+using std::istream;
+using std::ostream;
+using std::ostringstream;
+using std::string;
+
+// Writes the n-grams extracted from scripts in some output format. The
+// pattern of a skipped statement is the name of its status (see
+// NgramExtractor::StatusName).
+class NgramWriter {
+    public:
+        virtual ~NgramWriter() { }
+
+        // Starts the records of the script at path.
+        virtual void BeginScript(const string& path) = 0;
+        // Ends the records of the current script, if any; called after every
+        // script, even one that failed. Returns false if the records could
+        // not be stored, in which case none of them are kept.
+        virtual bool EndScript() { return true; }
+        // Writes a function of the current script, if WantsFunctions().
+        virtual void WriteFunction(int line, const string& signature) { }
+        virtual void Write(size_t line, int func, int n, const Ngram& ngram) = 0;
+
+        virtual bool WantsFunctions() const { return false; }
+};
+
+// The text format, one record per line:
+//   [<path> \t] <pattern> [\t <size> \t <op> \t <context>] [\t <line> \t <func>] [\t <n>]
+// Every record of a stream has the same columns, a skipped statement included.
+class TextNgramWriter : public NgramWriter {
+    public:
+        TextNgramWriter(ostream* out, bool tag, bool descriptions, bool positions, bool radii)
+            : out_(out), tag_(tag), descriptions_(descriptions), positions_(positions), radii_(radii) { }
+
+        virtual void BeginScript(const string& path);
+        virtual void Write(size_t line, int func, int n, const Ngram& ngram);
+
+    private:
+        ostream* out_;
+        const bool tag_;  // prefix every record with the script path
+        const bool descriptions_;  // follow the pattern with the long description
+        const bool positions_;  // suffix every record with its line and function
+        const bool radii_;  // and then with its n
+        string path_;
+};
+
+// The binary format. A stream starts with a header:
+//   "JSGB" <version> <flags>
+// and is followed by records, each of which starts with a kind byte:
+//   'S' <path size> <path>
+//   'F' <line> <signature size> <signature>
+//   'N' <line> <func> <n> <pattern size> <pattern> <size> <op size> <op>
+//       <context size> <context>
+// A script record precedes the function and n-gram records of the script. All integers
+// are unsigned LEB128 varints. The size of an n-gram without a long
+// description is 0, and its op and context are empty. The flags tell how to
+// render the stream in the text format.
+class BinaryNgramWriter : public NgramWriter {
+    public:
+        enum Flags {
+            kTagged = 1,
+            kPositions = 2,
+            kRadii = 4,
+            kDescriptions = 8
+        };
+
+        explicit BinaryNgramWriter(ostream* out) : out_(out) { }
+
+        static void WriteHeader(ostream* out, int flags);
+
+        virtual void BeginScript(const string& path);
+        virtual void WriteFunction(int line, const string& signature);
+        virtual void Write(size_t line, int func, int n, const Ngram& ngram);
+
+    private:
+        ostream* out_;
+};
+
+// Passes everything on to another writer, and also keeps a copy of the
+// records of the current script in the binary format (without the script
+// record), which can be replayed later with BinaryNgramReader::Replay.
+// Functions are always recorded.
+class RecordingNgramWriter : public NgramWriter {
+    public:
+        explicit RecordingNgramWriter(NgramWriter* writer) : writer_(writer), recorder_(&records_) { }
+
+        inline string records() const { return records_.str(); }
+
+        virtual void BeginScript(const string& path);
+        virtual void WriteFunction(int line, const string& signature);
+        virtual void Write(size_t line, int func, int n, const Ngram& ngram);
+
+        virtual bool WantsFunctions() const { return true; }
+
+    private:
+        NgramWriter* writer_;
+        ostringstream records_;
+        BinaryNgramWriter recorder_;
+};
+
+class BinaryNgramReader {
+    public:
+        enum Kind {
+            kScript = 'S',
+            kFunction = 'F',
+            kNgram = 'N'
+        };
+
+        struct Record {
+            Kind kind;
+            string path;  // of a script record
+            size_t line;  // of a function or an n-gram record
+            int func;  // of an n-gram record
+            int n;
+            Ngram ngram;
+            string signature;  // of a function record
+        };
+
+        explicit BinaryNgramReader(istream* in) : in_(in), malformed_(false) { }
+
+        // Returns false if the stream does not start with a valid header.
+        bool ReadHeader(int* flags);
+        // Returns false at the end of the stream or on a malformed record.
+        bool Next(Record* record);
+        inline bool malformed() const { return malformed_; }
+
+        // Feeds the function and n-gram records kept by a
+        // RecordingNgramWriter to another writer.
+        static bool Replay(const string& records, NgramWriter* writer);
+
+    private:
+        istream* in_;
+        bool malformed_;
+
+        bool ReadVarint(size_t* value);
+        bool ReadString(string* value);
+};
+
+#endif // NGRAMWRITER_H
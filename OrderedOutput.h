@@ -0,0 +1,66 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#ifndef ORDEREDOUTPUT_H
+#define ORDEREDOUTPUT_H
+
+#include <map>
+#include <ostream>
+#include <string>
+
+using std::map;
+using std::ostream;
+using std::string;
+
+// Writes the outputs of scripts numbered 0, 1, 2, ... to a stream. If ordered,
+// an output that arrives early is held back until all of its predecessors are
+// written; otherwise it is written right away. Not thread-safe.
+class OrderedOutput {
+    public:
+        OrderedOutput(ostream* out, bool ordered, size_t window)
+            : out_(out), ordered_(ordered), window_(window), next_(0) { }
+
+        // Whether the script numbered seq should wait before being started.
+        inline bool Full(size_t seq) const { return ordered_ && seq >= next_ + window_; }
+
+        // Returns true if some held-back outputs may have been released.
+        bool Write(size_t seq, const string& output) {
+            if (!ordered_) {
+                out_->write(output.data(), output.size());
+                return false;
+            }
+            if (seq != next_) {
+                pending_[seq] = output;
+                return false;
+            }
+            out_->write(output.data(), output.size());
+            for (++next_; !pending_.empty() && pending_.begin()->first == next_; ++next_) {
+                out_->write(pending_.begin()->second.data(), pending_.begin()->second.size());
+                pending_.erase(pending_.begin());
+            }
+            return true;
+        }
+
+    private:
+        ostream* out_;
+        const bool ordered_;
+        const size_t window_;
+        size_t next_;
+        map<size_t,string> pending_;
+};
+
+#endif // ORDEREDOUTPUT_H
@@ -22,10 +22,13 @@
 #include <isolate.h>
 #include <sstream>
 #include <queue>
+#include "CanonicalLabeler.h"
 
 using std::cerr;
 using std::cout;
 using std::endl;
+using std::lexicographical_compare;
+using std::lower_bound;
 using std::make_pair;
 using std::max;
 using std::min;
@@ -34,38 +37,65 @@ using std::queue;
 using std::random_shuffle;
 using std::reverse;
 using std::sort;
+using std::unique;
 using std::ostringstream;
 using std::swap;
 
-string PDGExtractor::Extract(Statement* node, int n, bool long_desc) {
+void PDGExtractor::Extract(int node, int n, bool long_desc, Ngram* ngram) {
+    if (grower_.node() != node || grower_.radius() > n || long_desc != last_long_desc_) {
+    	grower_.Reset(node);
+    	grower_.Grow(n);
+    } else if (!grower_.Grow(n)) {
+    	// the same neighborhood as the last radius gives the same n-gram
+    	status_ = last_status_;
+    	*ngram = last_ngram_;
+    	return;
+    }
+    last_long_desc_ = long_desc;
+    ExtractNeighborhood(node, n, long_desc, &last_ngram_);
+    last_status_ = status_;
+    *ngram = last_ngram_;
+}
+
+void PDGExtractor::ExtractNeighborhood(int node, int n, bool long_desc, Ngram* ngram) {
+    status_ = kExtracted;
     focal_ = node;
-    neighborhood_ = graph_.GetNeighborhood(node, n);
-    if (neighborhood_.size() > size_limit_) {
-    	return "";
+    *ngram = Ngram();
+    if (long_desc)
+	ngram->op = GetOp(node)->first;
+    const size_t size = grower_.members().size();
+    if (size > size_limit_) {
+    	status_ = kTooLarge;
+    	return;
+    }
+    vector<string>& cached_patterns = cached_patterns_[n];
+    vector<string>& cached_contexts = cached_contexts_[n];
+    if (cached_patterns.empty()) {
+    	cached_patterns.resize(graph_.size());
+    	cached_contexts.resize(graph_.size());
     }
-    if (cached_patterns_[n].count(node)) {
-    	min_pattern_ = cached_patterns_[n][node];
+    if (cached_patterns[node] != "") {
+    	min_pattern_ = cached_patterns[node];
     } else {
-	FindMinimalPattern();
-	cached_patterns_[n][node] = min_pattern_;
+	if (!FindPattern(0))
+	    return;
+	cached_patterns[node] = min_pattern_;
     }
-    ostringstream out;
-    out << min_pattern_;
+    const string pattern = Output(min_pattern_);
     if (long_desc) {
-    	out << '\t' << neighborhood_.size();
-    	out << '\t' << Serialize(node);
-    	for (DependenceGraph::iterator i = neighborhood_.begin(); i != neighborhood_.end(); ++i)
-	    i->second.remove(node);
-	//for (list<Statement*>::iterator i = reverse_neighborhood_[node].begin(); i != reverse_neighborhood_[node].end(); ++i)
-	//    neighborhood_[*i].remove(node);
-	//for (list<Statement*>::iterator i = neighborhood_[node].begin(); i != neighborhood_[node].end(); ++i)
-	//    reverse_neighborhood_[*i].remove(node);
-	neighborhood_.erase(node);
-	//reverse_neighborhood_.erase(node);
-	FindMinimalPattern();
-	out << '\t' << min_pattern_;
+	// the context is the neighborhood without the node, which is its first
+	// member and is simply skipped
+	if (cached_contexts[node] != "") {
+	    min_pattern_ = cached_contexts[node];
+	} else {
+	    if (!FindPattern(1))
+		return;
+	    cached_contexts[node] = min_pattern_;
+	}
+	ngram->size = size;
+	ngram->context = Output(min_pattern_);
     }
-    return out.str();
+    ngram->pattern = pattern;
 }
 
 /*void PDGExtractor::Count(int k) {
@@ -82,28 +112,23 @@ void PDGExtractor::Print(Statement* node, int k) {
 }*/
 
 int PDGExtractor::CompareNode(Node* const& x, Node* const& y) const {
-    int ret;
-    int x_type = x->statement->node_type();
-    int y_type = y->statement->node_type();
-    if (x_type != y_type) {
-	if (x_type == kCanonicalFunctionEntry || y_type == kCanonicalFunctionExit)
-	    return -1;
-	if (y_type == kCanonicalFunctionEntry || x_type == kCanonicalFunctionExit)
-	    return 1;
-    }
-    if ((ret = x->level.first - y->level.first) != 0)
-	return ret;
-    if ((ret = x->level.second - y->level.second) != 0)
-	return ret;
-    if ((ret = x->predecessors.size() - y->predecessors.size()) != 0)
-	return ret;
-    if ((ret = x->successors.size() - y->successors.size()) != 0)
-	return ret;
-    if ((ret = x_type - y_type) != 0)
-	return ret;
-    if ((ret = x->serialization.compare(y->serialization)) != 0)
-    	return ret;
-    return x->adjacency <= y->adjacency ? x->adjacency < y->adjacency ? -1 : 0 : 1;
+    if (x->key[0] != y->key[0])
+    	return x->key[0] < y->key[0] ? -1 : 1;
+    if (x->key[1] != y->key[1])
+    	return x->key[1] < y->key[1] ? -1 : 1;
+    return x->adjacency.Compare(y->adjacency);
+}
+
+// Packs everything CompareNode() looks at before the adjacency, in this order:
+// function entries first and exits last, the min and max levels, the numbers
+// of predecessors and successors, the node type and the op.
+void PDGExtractor::PackKey(Node* node) {
+    const uint64_t bias = 1 << 19;  // levels may drop below 0 in cycles
+    uint64_t position = node->type == kCanonicalFunctionEntry ? 0 : node->type == kCanonicalFunctionExit ? 2 : 1;
+    node->key[0] = position << 60 | (node->level.first + bias) << 40 | (node->level.second + bias) << 20 |
+                   node->predecessors.size();
+    node->key[1] = static_cast<uint64_t>(node->successors.size()) << 44 | static_cast<uint64_t>(node->type) << 32 |
+                   node->op_rank;
 }
 
 int PDGExtractor::CompareSymmetry(Node* const& x, Node* const& y) const {
@@ -131,60 +156,151 @@ void PDGExtractor::SetMinLevel(Node* node) {
     if (node->level.first)
     	return;
     node->level.first = 1;
-    for (list<Node*>::iterator i = node->predecessors.begin(); i != node->predecessors.end(); ++i) {
-	if (lexical_order_[(*i)->statement] < lexical_order_[node->statement]) {
-	    SetMinLevel(*i);
-	    node->level.first = max(node->level.first, (*i)->level.first + 1);
+    for (vector<int>::iterator i = node->predecessors.begin(); i != node->predecessors.end(); ++i) {
+    	Node* predecessor = &nodes_[*i];
+	if (predecessor->lexical_order < node->lexical_order) {
+	    SetMinLevel(predecessor);
+	    node->level.first = max(node->level.first, predecessor->level.first + 1);
 	}
     }
 }
 
 const char* PDGExtractor::ToCString(size_t index) {
-    static char buf[16] = " ";
-    char* ptr = buf + 1;
+    char* ptr = index_buf_ + 1;
     do {
     	*ptr++ = index % 10 + '0';
     	index /= 10;
     } while (index);
     *ptr = '\0';
-    reverse(buf + 1, ptr);
-    return buf;
+    reverse(index_buf_ + 1, ptr);
+    return index_buf_;
+}
+
+// Returns an upper bound of the number of orders SearchOrder() may explore,
+// which is the product of the factorials of the tie cell sizes. The cells may
+// be split further by the adjacency during the search, so this is pessimistic
+// for sparse neighborhoods but exact for fully symmetric ones.
+size_t PDGExtractor::EstimateCost() const {
+    const size_t saturated = static_cast<size_t>(-1);
+    size_t cost = 1;
+    for (size_t i = 0; i < range_.size(); i = range_[i]) {
+    	for (size_t k = 2; k <= range_[i] - i; ++k) {
+    	    if (cost > saturated / k)
+    	    	return saturated;
+    	    cost *= k;
+	}
+    }
+    return cost;
+}
+
+static inline void AppendInt(string* s, int value) {
+    s->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Describes in structure_ everything a search of the neighborhood of grower_
+// without its members before the first one depends on, node by node in the
+// order they are laid out: the type, whether it is the focal node and the op,
+// followed by the position of every predecessor, negated if the predecessor
+// does not come earlier lexically. Neighborhoods described alike get the same
+// pattern, whether or not they are isomorphic in any other way.
+void PDGExtractor::DescribeStructure(size_t first) {
+    const vector<int>& members = grower_.members();
+    const vector<NeighborhoodGrower::Edge>& edges = grower_.edges();
+    vector<NeighborhoodGrower::Edge>::const_iterator edge = edges.begin();
+    structure_.clear();
+    for (size_t i = first; i < members.size(); ++i) {
+    	const string& op = GetOp(members[i])->first;
+    	AppendInt(&structure_, graph_.type(members[i]));
+    	AppendInt(&structure_, members[i] == focal_);
+    	AppendInt(&structure_, op.size());
+    	structure_ += op;
+    	while (edge != edges.end() && static_cast<size_t>(edge->from) < i)
+    	    ++edge;
+	for (; edge != edges.end() && static_cast<size_t>(edge->from) == i; ++edge) {
+	    if (static_cast<size_t>(edge->to) >= first) {
+		int position = edge->to - first + 1;
+		AppendInt(&structure_, lexical_order_[members[edge->to]] < lexical_order_[members[i]] ? position : -position);
+	    }
+	}
+	AppendInt(&structure_, 0);
+    }
 }
 
-void PDGExtractor::FindMinimalPattern() {
-    min_pattern_ = curr_pattern_ = "";
+// Searches the neighborhood of grower_ without its members before the first
+// one, or takes the result of an earlier search of the same structure from
+// the cache. Returns false if the search is skipped or abandoned; the reason
+// is left in status_.
+bool PDGExtractor::FindPattern(size_t first) {
+    if (structures_) {
+    	DescribeStructure(first);
+    	int status;
+    	if (structures_->Lookup(structure_, &status, &min_pattern_)) {
+    	    ++reuses_;
+    	    status_ = static_cast<Status>(status);
+    	    return status_ == kExtracted;
+	}
+    }
+    bool found = refine_ ? FindCanonicalPattern(first) : FindMinimalPattern(first);
+    if (structures_)
+    	structures_->Store(structure_, status_, min_pattern_);
+    return found;
+}
 
-    // initialize nodes
+bool PDGExtractor::FindMinimalPattern(size_t first) {
+    min_pattern_ = "";
+    min_tokens_.clear();
+    curr_tokens_.clear();
+
+    // initialize nodes, which are laid out in the order of the members and
+    // kept for the next search along with the memory they hold
+    const vector<int>& members = grower_.members();
+    size_t size = members.size() - first;
+    if (size > num_nodes_) {
+    	delete[] nodes_;
+    	num_nodes_ = max(size, 2 * num_nodes_);
+    	nodes_ = new Node[num_nodes_];
+    }
     curr_order_.clear();
-    map<Statement*,Node*> node_map;
-    for (key_iterator<DependenceGraph> i = neighborhood_.begin(); i != neighborhood_.end(); ++i) {
-        Node* node = new Node;
-    	node->statement = *i;
+    for (size_t i = first; i < members.size(); ++i) {
+        Node* node = &nodes_[curr_order_.size()];
+    	node->statement = members[i];
+    	node->type = graph_.type(members[i]);
+    	node->lexical_order = lexical_order_[members[i]];
+    	node->predecessors.clear();
+    	node->successors.clear();
     	node->level = make_pair(0, 0);
-    	node->adjacency.assign(neighborhood_.size(), false);
-    	node->serialization = Serialize(*i);
-    	node_map[*i] = node;
+    	node->adjacency.Assign(size);
+    	node->op = GetOp(members[i]);
+    	node->parent = node;
+    	node->rank = 0;
     	curr_order_.push_back(node);
     }
-    for (DependenceGraph::iterator i = neighborhood_.begin(); i != neighborhood_.end(); ++i) {
-    	for (list<Statement*>::iterator j = i->second.begin(); j != i->second.end(); ++j) {
-	    node_map[i->first]->predecessors.push_back(node_map[*j]);
-	    node_map[*j]->successors.push_back(node_map[i->first]);
-	}
+    const vector<NeighborhoodGrower::Edge>& edges = grower_.edges();
+    for (vector<NeighborhoodGrower::Edge>::const_iterator i = edges.begin(); i != edges.end(); ++i) {
+    	size_t from = i->from, to = i->to;
+    	if (from < first || to < first)
+    	    continue;
+	nodes_[from - first].predecessors.push_back(to - first);
+	nodes_[to - first].successors.push_back(from - first);
     }
+    AssignTokens();
 
     // set min/max levels
     for (vector<Node*>::iterator i = curr_order_.begin(); i != curr_order_.end(); ++i)
 	SetMinLevel(*i);
+    for (vector<Node*>::iterator i = curr_order_.begin(); i != curr_order_.end(); ++i)
+    	PackKey(*i);
     sort(curr_order_.begin(), curr_order_.end(), mem_fun_less(this, &PDGExtractor::CompareNode));
     for (vector<Node*>::iterator i = curr_order_.begin(); i != curr_order_.end(); ++i)
 	(*i)->level.second = curr_order_.back()->level.first;
     for (vector<Node*>::reverse_iterator i = curr_order_.rbegin(); i != curr_order_.rend(); ++i) {
-    	for (list<Node*>::iterator j = (*i)->predecessors.begin(); j != (*i)->predecessors.end(); ++j) {
-    	    if (lexical_order_[(*j)->statement] < lexical_order_[(*i)->statement])
-		(*j)->level.second = min((*j)->level.second, (*i)->level.second - 1);
+    	for (vector<int>::iterator j = (*i)->predecessors.begin(); j != (*i)->predecessors.end(); ++j) {
+    	    if (nodes_[*j].lexical_order < (*i)->lexical_order)
+		nodes_[*j].level.second = min(nodes_[*j].level.second, (*i)->level.second - 1);
 	}
     }
+    for (vector<Node*>::iterator i = curr_order_.begin(); i != curr_order_.end(); ++i)
+    	PackKey(*i);
     sort(curr_order_.begin(), curr_order_.end(), mem_fun_less(this, &PDGExtractor::CompareNode));
 
     // set range
@@ -196,37 +312,134 @@ void PDGExtractor::FindMinimalPattern() {
 	    range_.push_back(i);
     }
 
-    //count_ = 0;
-    SearchOrder(0);
+    count_ = 0;
+    if (cost_limit_ && EstimateCost() > cost_limit_) {
+    	status_ = kTooCostly;
+    } else {
+	SearchOrder(0);
+	for (vector<int>::iterator i = min_tokens_.begin(); i != min_tokens_.end(); ++i)
+	    min_pattern_ += TokenText(*i);
+    }
+    return status_ == kExtracted;
+}
 
-    for (vector<Node*>::iterator i = curr_order_.begin(); i != curr_order_.end(); ++i)
-    	delete *i;
+bool PDGExtractor::FindCanonicalPattern(size_t first) {
+    CanonicalLabeler labeler(count_limit_);
+    const vector<int>& members = grower_.members();
+    for (size_t i = first; i < members.size(); ++i)
+    	labeler.AddVertex(GetOp(members[i])->first, members[i] == focal_);
+    const vector<NeighborhoodGrower::Edge>& edges = grower_.edges();
+    for (vector<NeighborhoodGrower::Edge>::const_iterator i = edges.begin(); i != edges.end(); ++i) {
+    	size_t from = i->from, to = i->to;
+    	if (from >= first && to >= first)
+    	    labeler.AddEdge(from - first, to - first);
+    }
+    if (!labeler.Label(&min_pattern_)) {
+    	status_ = kOverBudget;
+    	return false;
+    }
+    return true;
 }
 
-void PDGExtractor::SearchOrder(size_t index) {
-    //if (count_ > count_limit_)
-    //	return;
+// Patterns are searched as sequences of tokens: "(op " or "(op)" for a node,
+// with brackets for the focal one, and "j " or "j)" or "j]" for the position
+// of a predecessor. A token is its group, ordered like the first characters
+// '(', digits and '[', above its rank in the group. As long as no token is a
+// prefix of another, which the serializations never cause, comparing tokens
+// compares the patterns as strings. Only the minimal pattern is rendered.
+static const int kGroupShift = 24;
+
+// Returns the op of a statement, which is serialized only the first time.
+map<string,PDGExtractor::Op>::value_type* PDGExtractor::GetOp(int node) {
+    if (!statement_ops_[node]) {
+    	pair<map<string,Op>::iterator,bool> inserted = ops_.insert(make_pair(graph_.op(node), Op()));
+    	statement_ops_[node] = &*inserted.first;
+    	ops_added_ |= inserted.second;
+    }
+    return statement_ops_[node];
+}
+
+void PDGExtractor::AssignTokens() {
+    // all the ops seen so far are ranked again whenever a new one shows up
+    if (ops_added_) {
+    	ops_added_ = false;
+    	static const char* const kOpen[] = {"(", "(", "[", "["};
+    	static const char kClose[] = {' ', ')', ' ', ']'};
+    	node_texts_.clear();
+    	for (map<string,Op>::iterator i = ops_.begin(); i != ops_.end(); ++i) {
+    	    for (int k = 0; k < 4; ++k)
+    	    	node_texts_.push_back(kOpen[k] + i->first + kClose[k]);
+	}
+	sort(node_texts_.begin(), node_texts_.end());
+	int rank = 0;
+	for (map<string,Op>::iterator i = ops_.begin(); i != ops_.end(); ++i) {
+	    i->second.rank = rank++;
+	    for (int k = 0; k < 4; ++k) {
+	    	int text = lower_bound(node_texts_.begin(), node_texts_.end(), kOpen[k] + i->first + kClose[k]) - node_texts_.begin();
+	    	i->second.tokens[k] = (k < 2 ? 0 : 2 << kGroupShift) + text;
+	    }
+	}
+    }
+    for (vector<Node*>::iterator i = curr_order_.begin(); i != curr_order_.end(); ++i) {
+    	const Op& op = (*i)->op->second;
+    	bool focal = (*i)->statement == focal_;
+    	(*i)->op_rank = op.rank;
+    	(*i)->open_token = op.tokens[focal ? 2 : 0];
+    	(*i)->closed_token = op.tokens[focal ? 3 : 1];
+    	(*i)->terminator = focal ? 2 : 1;
+    }
+
+    // positions do not depend on the neighborhood and are kept for later searches
+    size_t size = position_tokens_.size() / 3;
+    if (size < curr_order_.size()) {
+    	size = max(curr_order_.size(), 2 * size);
+    	vector<string> texts;
+    	for (size_t j = 0; j < size; ++j) {
+    	    string position = ToCString(j) + 1;
+    	    texts.push_back(position + ' ');
+    	    texts.push_back(position + ')');
+    	    texts.push_back(position + ']');
+	}
+	position_texts_ = texts;
+	sort(position_texts_.begin(), position_texts_.end());
+	position_tokens_.clear();
+	for (vector<string>::iterator i = texts.begin(); i != texts.end(); ++i)
+	    position_tokens_.push_back((1 << kGroupShift) + (lower_bound(position_texts_.begin(), position_texts_.end(), *i) - position_texts_.begin()));
+    }
+}
+
+const string& PDGExtractor::TokenText(int token) const {
+    int rank = token & ((1 << kGroupShift) - 1);
+    return token >> kGroupShift == 1 ? position_texts_[rank] : node_texts_[rank];
+}
 
+void PDGExtractor::SearchOrder(size_t index) {
     if (index == curr_order_.size()) {
-        if (min_pattern_.empty() || curr_pattern_ < min_pattern_) {
-            min_pattern_ = curr_pattern_;
+    	if (count_limit_ && count_ == count_limit_) {
+    	    status_ = kOverBudget;
+    	    return;
+	}
+        if (min_tokens_.empty() || curr_tokens_ < min_tokens_) {
+            min_tokens_ = curr_tokens_;
             min_order_ = curr_order_;
-        } else if (curr_pattern_ == min_pattern_) {
+        } else if (curr_tokens_ == min_tokens_) {
             size_t i;
             for (i = 0; i < min_order_.size() && min_order_[i] == curr_order_[i]; ++i)
                 ;
             if (i < min_order_.size() && CompareNode(min_order_[i], curr_order_[i]) == 0)
                 min_order_[i]->Union(curr_order_[i]);
         }
-    	//++count_;
+    	++count_;
+    	++orders_;
     	return;
     }
 
     // reorder nodes according to their ordered predecessors
     size_t pivot = index + 1;
     for (size_t i = index + 1; i < range_[index]; ++i) {
-    	if (curr_order_[i]->adjacency <= curr_order_[index]->adjacency) {
-    	    if (curr_order_[i]->adjacency < curr_order_[index]->adjacency)
+    	int ret = curr_order_[i]->adjacency.Compare(curr_order_[index]->adjacency);
+    	if (ret <= 0) {
+    	    if (ret < 0)
     	    	pivot = index;
     	    swap(curr_order_[pivot++], curr_order_[i]);
 	}
@@ -234,20 +447,29 @@ void PDGExtractor::SearchOrder(size_t index) {
 
     sort(curr_order_.begin() + index, curr_order_.begin() + pivot);//, mem_fun_less(this, &PDGExtractor::CompareSymmetry));
 
-    size_t len = curr_pattern_.size();
+    size_t len = curr_tokens_.size();
     //for (int t = (pivot - index) << 2; t; --t) { // enumerate all if n <= 3, o.w. 4n random ones
     while (true) { // enumerate all
-    	curr_pattern_.resize(len);
+    	curr_tokens_.resize(len);
     	for (size_t i = index; i < pivot; ++i) {
-    	    for (list<Node*>::iterator k = curr_order_[i]->successors.begin(); k != curr_order_[i]->successors.end(); ++k)
-    	    	(*k)->adjacency[i] = true;
-    	    curr_pattern_ += curr_order_[i]->statement == focal_ ? "[" : "(";
-    	    curr_pattern_ += curr_order_[i]->serialization;
-    	    for (size_t j = 0; j < curr_order_[i]->adjacency.size(); ++j) {
-    	    	if (curr_order_[i]->adjacency[j])
-		    curr_pattern_ += ToCString(j);
+    	    for (vector<int>::iterator k = curr_order_[i]->successors.begin(); k != curr_order_[i]->successors.end(); ++k)
+    	    	nodes_[*k].adjacency.Set(i);
+    	    const BitVector& adjacency = curr_order_[i]->adjacency;
+    	    size_t j = adjacency.Next(0);
+    	    if (j == adjacency.size()) {
+    	    	curr_tokens_.push_back(curr_order_[i]->closed_token);
+    	    	continue;
+	    }
+	    curr_tokens_.push_back(curr_order_[i]->open_token);
+	    while (true) {
+	    	size_t next = adjacency.Next(j + 1);
+	    	if (next == adjacency.size()) {
+	    	    curr_tokens_.push_back(position_tokens_[3 * j + curr_order_[i]->terminator]);
+	    	    break;
+		}
+		curr_tokens_.push_back(position_tokens_[3 * j]);
+		j = next;
 	    }
-    	    curr_pattern_ += curr_order_[i]->statement == focal_ ? "]" : ")";
 	}
 
 /*
@@ -261,7 +483,13 @@ void PDGExtractor::SearchOrder(size_t index) {
         }
 */
 
-        SearchOrder(pivot);
+	// every completion of a prefix greater than the minimal pattern is
+	// greater too, so it can neither replace nor tie with it
+	if (!min_tokens_.empty() && lexicographical_compare(min_tokens_.begin(), min_tokens_.begin() + min(min_tokens_.size(), curr_tokens_.size()),
+	                                                     curr_tokens_.begin(), curr_tokens_.end()))
+	    ++cuts_;
+	else
+	    SearchOrder(pivot);
 
 /*
         if (pivot - index > 1) {
@@ -278,9 +506,11 @@ void PDGExtractor::SearchOrder(size_t index) {
 */
 
     	for (size_t i = index; i < pivot; ++i) {
-    	    for (list<Node*>::iterator k = curr_order_[i]->successors.begin(); k != curr_order_[i]->successors.end(); ++k)
-    	    	(*k)->adjacency[i] = false;
+    	    for (vector<int>::iterator k = curr_order_[i]->successors.begin(); k != curr_order_[i]->successors.end(); ++k)
+    	    	nodes_[*k].adjacency.Reset(i);
 	}
+	if (status_ == kOverBudget)
+	    break;
     	/*if (pivot - index > 3) {
     	    random_shuffle(curr_order_.begin() + index, curr_order_.begin() + pivot);
 	} else*/
@@ -18,35 +18,75 @@
 #ifndef PDGEXTRACTOR_H
 #define PDGEXTRACTOR_H
 
+#include <algorithm>
 #include <map>
+#include <stdint.h>
 #include <utility>
 #include <vector>
+#include "BitVector.h"
 #include "CanonicalAst.h"
 #include "DependenceGraph.h"
 #include "NgramExtractor.h"
+#include "StructureCache.h"
 #include "Utility.h"
 
 using std::map;
 using std::pair;
+using std::sort;
 using std::string;
 using std::vector;
 
 class PDGExtractor : public NgramExtractor {
     public:
-	template <class Compare> PDGExtractor(const DependenceGraph &graph, Compare cmp, size_t limit)
-	    : graph_(graph), size_limit_(limit) {
-	    list<Statement*> nodes;
-	    for (key_iterator<DependenceGraph> i = graph_.begin(); i != graph_.end(); ++i)
-	    	nodes.push_back(*i);
-	    nodes.sort(cmp);
-	    int rank = 0;
-	    for (list<Statement*>::iterator i = nodes.begin(); i != nodes.end(); ++i)
-	    	lexical_order_[*i] = rank++;
+	// Neighborhoods larger than size_limit are not extracted. A search whose
+	// estimated number of orders exceeds cost_limit is not started, and one
+	// that explores more than count_limit orders is abandoned; 0 means no
+	// limit for both. If refine is set, patterns are found by a
+	// CanonicalLabeler instead of the order search; they differ from the
+	// ones of the order search, and cost_limit does not apply. The lexical
+	// order of the statements is given by cmp, which compares ids.
+	template <class Compare> PDGExtractor(const DependenceGraph &graph, Compare cmp, size_t size_limit,
+	                                      size_t cost_limit = 0, size_t count_limit = 0, bool refine = false)
+	    : graph_(graph), lexical_order_(graph.size()), statement_ops_(graph.size()), ops_added_(false),
+	      size_limit_(size_limit), cost_limit_(cost_limit), count_limit_(count_limit), refine_(refine), orders_(0),
+	      cuts_(0), reuses_(0), nodes_(NULL), num_nodes_(0), structures_(NULL), grower_(graph) {
+	    index_buf_[0] = ' ';
+	    vector<int> nodes;
+	    for (int i = 0; i < graph.size(); ++i)
+	    	nodes.push_back(i);
+	    sort(nodes.begin(), nodes.end(), cmp);
+	    for (size_t i = 0; i < nodes.size(); ++i)
+	    	lexical_order_[nodes[i]] = i;
 	}
 
-	string Extract(Statement* node, int n, bool long_desc = false);
+	~PDGExtractor() {
+	    delete[] nodes_;
+	}
+
+	// Asking for the radii of a node in increasing order is cheaper than in
+	// any other order, as the neighborhood is grown from the previous one.
+	using NgramExtractor::Extract;
+	void Extract(int node, int n, bool long_desc, Ngram* ngram);
+
+	// Numbers of complete orders explored, and of partial orders cut off
+	// because their patterns already exceeded the minimal one, by all the
+	// order searches so far.
+	inline size_t orders() const { return orders_; }
+	inline size_t cuts() const { return cuts_; }
+	// Number of searches answered by the structure cache.
+	inline size_t reuses() const { return reuses_; }
+
+	// Makes the searches look their neighborhoods up in cache first, and
+	// store their results into it. The cache must only be shared by
+	// extractors with the same limits.
+	inline void set_structure_cache(StructureCache* cache) { structures_ = cache; }
 
     private:
+	struct Op {
+	    int rank;
+	    int tokens[4];  // "(op ", "(op)", "[op " and "[op]"
+	};
+
 	struct Node {
 	    Node() : parent(this), rank(0) { }
 
@@ -68,36 +108,74 @@ class PDGExtractor : public NgramExtractor {
                 }
             }
 
-	    Statement* statement;
-	    list<Node*> predecessors;
-	    list<Node*> successors;
+	    int statement;  // id
+	    int type;
+	    int lexical_order;
+	    vector<int> predecessors;  // indices into nodes_
+	    vector<int> successors;
 	    pair<int,int> level;
-	    vector<bool> adjacency;
-	    string serialization;
+	    uint64_t key[2];  // what CompareNode looks at before the adjacency
+	    BitVector adjacency;  // positions of the ordered predecessors
+	    map<string,Op>::value_type* op;  // the serialization and its tokens
+	    int op_rank;  // of the serialization among all ops seen
+	    int open_token;  // "(op " or "[op "
+	    int closed_token;  // "(op)" or "[op]"
+	    int terminator;  // 1 for ")" and 2 for "]"
             Node* parent;
             int rank;
 	};
 
+	void ExtractNeighborhood(int node, int n, bool long_desc, Ngram* ngram);
 	int CompareNode(Node* const& x, Node* const& y) const;
 	int CompareSymmetry(Node* const& x, Node* const& y) const;
 	//int CompareSuccessors(Node* const& x, Node* const& y) const;
 	const char* ToCString(size_t index);
 	void SetMinLevel(Node* node);
-	void FindMinimalPattern();
+	void PackKey(Node* node);
+	size_t EstimateCost() const;
+	map<string,Op>::value_type* GetOp(int node);
+	void AssignTokens();
+	const string& TokenText(int token) const;
+	void DescribeStructure(size_t first);
+	bool FindPattern(size_t first);
+	bool FindMinimalPattern(size_t first);
+	bool FindCanonicalPattern(size_t first);
 	void SearchOrder(size_t index);
 
-	Statement* focal_;
-	DependenceGraph graph_;
-	DependenceGraph neighborhood_;
-	map<Statement*,int> lexical_order_;
+	int focal_;
+	const DependenceGraph& graph_;
+	vector<int> lexical_order_;  // by id
 	vector<Node*> min_order_;
 	vector<Node*> curr_order_;
 	vector<size_t> range_;
 	string min_pattern_;
-	string curr_pattern_;
+	vector<int> min_tokens_;
+	vector<int> curr_tokens_;
+	map<string,Op> ops_;  // every op seen
+	vector<map<string,Op>::value_type*> statement_ops_;  // by id, NULL until first searched
+	bool ops_added_;  // since the ops were last ranked
+	vector<string> node_texts_;  // by rank
+	vector<string> position_texts_;  // by rank
+	vector<int> position_tokens_;  // "j ", "j)" and "j]" of every position j
 	const size_t size_limit_;
+	const size_t cost_limit_;
+	const size_t count_limit_;
+	const bool refine_;
 	size_t count_;
-	map<int,map<Statement*,string> > cached_patterns_;
+	size_t orders_;
+	size_t cuts_;
+	size_t reuses_;
+	Node* nodes_;  // reused by every search, with room for num_nodes_ nodes
+	size_t num_nodes_;
+	map<int,vector<string> > cached_patterns_;  // by radius and id
+	map<int,vector<string> > cached_contexts_;
+	StructureCache* structures_;
+	string structure_;  // of the last search
+	NeighborhoodGrower grower_;
+	bool last_long_desc_;  // of the last n-gram extracted from grower_
+	Ngram last_ngram_;
+	Status last_status_;
+	char index_buf_[16];
 };
 
 #endif // PDGEXTRACTOR_H
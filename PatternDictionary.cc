@@ -0,0 +1,85 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#include "PatternDictionary.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+PatternDictionary::PatternDictionary(const string& path) : fd_(-1), recording_(NULL) {
+    if (!path.empty())
+        fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0666);
+}
+
+PatternDictionary::~PatternDictionary() {
+    Flush();
+    if (fd_ >= 0)
+        close(fd_);
+}
+
+string PatternDictionary::Fingerprint(const string& pattern) {
+    Hash128 hash(pattern.data(), pattern.size());
+    string hex = hash.ToHex();
+    if (fd_ < 0)
+        return hex;
+    const bool seen = !seen_.insert(hash).second;
+    const bool recorded = !recording_ || !recorded_.insert(hash).second;
+    if (seen && recorded)
+        return hex;
+    const string line = hex + '\t' + pattern + '\n';
+    if (!recorded)
+        *recording_ += line;
+    if (!seen) {
+        buffer_ += line;
+        if (buffer_.size() >= 65536)
+            Flush();
+    }
+    return hex;
+}
+
+void PatternDictionary::set_recording(string* lines) {
+    recording_ = lines;
+    recorded_.clear();
+}
+
+void PatternDictionary::Add(const string& lines) {
+    size_t start = 0;
+    while (start < lines.size()) {
+        size_t end = lines.find('\n', start);
+        if (end == string::npos)
+            end = lines.size();
+        size_t tab = lines.find('\t', start);
+        if (tab < end)
+            Fingerprint(lines.substr(tab + 1, end - tab - 1));
+        start = end + 1;
+    }
+}
+
+void PatternDictionary::Flush() {
+    // the buffer only holds whole lines, and each write is appended as a unit
+    while (!buffer_.empty()) {
+        ssize_t n = write(fd_, buffer_.data(), buffer_.size());
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n > 0)
+            buffer_.erase(0, n);
+        else
+            break;
+    }
+    buffer_.clear();
+}
@@ -0,0 +1,60 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#ifndef PATTERNDICTIONARY_H
+#define PATTERNDICTIONARY_H
+
+#include <set>
+#include <string>
+#include "Hash.h"
+
+using std::set;
+using std::string;
+
+// Replaces canonical patterns with their 128-bit fingerprints. Each pattern is
+// also appended to a side file as a "<fingerprint>\t<pattern>" line the first
+// time this dictionary sees it. Lines go out in single appending writes, so
+// any number of dictionaries may share the side file; a pattern may then be
+// listed more than once.
+//
+// The lines of the patterns fingerprinted for a script can also be recorded,
+// so that a script whose results are replayed from a cache still gets its
+// patterns listed.
+class PatternDictionary {
+    public:
+        // path names the side file, or is empty for none.
+        explicit PatternDictionary(const string& path);
+        ~PatternDictionary();
+
+        string Fingerprint(const string& pattern);
+        // Appends the line of every distinct pattern fingerprinted from now
+        // on to lines, whether it is seen or not; NULL stops recording.
+        void set_recording(string* lines);
+        // Fingerprints the patterns of recorded lines.
+        void Add(const string& lines);
+        // Writes out the lines buffered so far.
+        void Flush();
+
+    private:
+        int fd_;
+        set<Hash128> seen_;
+        string buffer_;
+        string* recording_;
+        set<Hash128> recorded_;
+};
+
+#endif // PATTERNDICTIONARY_H
@@ -0,0 +1,75 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#include "ScriptCache.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+ScriptCache::ScriptCache(const string& dir, const string& options) : dir_(dir) {
+    mkdir(dir_.c_str(), 0777);
+    seed_ = Hash128(options.data(), options.size()).h1;
+}
+
+Hash128 ScriptCache::Key(const char* data, size_t size) const {
+    return Hash128(data, size, seed_);
+}
+
+string ScriptCache::Path(const Hash128& key) const {
+    string hex = key.ToHex();
+    return dir_ + '/' + hex.substr(0, 2) + '/' + hex.substr(2);
+}
+
+bool ScriptCache::Lookup(const Hash128& key, string* entry) const {
+    int fd = open(Path(key).c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    entry->clear();
+    char buf[65536];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0)
+        entry->append(buf, n);
+    close(fd);
+    return n == 0;
+}
+
+void ScriptCache::Store(const Hash128& key, const string& entry) const {
+    string path = Path(key);
+    mkdir(path.substr(0, path.rfind('/')).c_str(), 0777);
+    string temp = path + ".XXXXXX";
+    int fd = mkstemp(&temp[0]);
+    if (fd < 0)
+        return;
+    const char* data = entry.data();
+    size_t size = entry.size();
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        data += n;
+        size -= n;
+    }
+    if (close(fd) == 0 && size == 0 && rename(temp.c_str(), path.c_str()) == 0)
+        return;
+    unlink(temp.c_str());
+}
@@ -0,0 +1,50 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#ifndef SCRIPTCACHE_H
+#define SCRIPTCACHE_H
+
+#include <string>
+#include "Hash.h"
+
+using std::string;
+
+// A persistent cache of extraction results on disk, keyed by the hash of the
+// script content and the options that affect the result. An entry is stored
+// in <dir>/<2 hex digits>/<30 hex digits>, and is written to a temporary file
+// first and then renamed into place, so any number of threads and processes
+// may share the same directory.
+class ScriptCache {
+    public:
+        // options describes everything besides the content that the result
+        // depends on.
+        ScriptCache(const string& dir, const string& options);
+
+        Hash128 Key(const char* data, size_t size) const;
+
+        // Returns false on a miss.
+        bool Lookup(const Hash128& key, string* entry) const;
+        void Store(const Hash128& key, const string& entry) const;
+
+    private:
+        const string dir_;
+        uint64_t seed_;
+
+        string Path(const Hash128& key) const;
+};
+
+#endif // SCRIPTCACHE_H
@@ -0,0 +1,199 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#include "ScriptList.h"
+
+#include <algorithm>
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/stat.h>
+
+using std::cerr;
+using std::cin;
+using std::endl;
+using std::getline;
+using std::ifstream;
+using std::ostringstream;
+using std::reverse;
+using std::sort;
+
+ScriptList::~ScriptList() {
+    if (list_ != &cin)
+        delete list_;
+    delete warc_;
+}
+
+void ScriptList::AddFile(const string& path) {
+    Source source = {Source::SCRIPT, path};
+    sources_.push_back(source);
+}
+
+void ScriptList::AddList(const string& path) {
+    Source source = {Source::LIST, path};
+    sources_.push_back(source);
+}
+
+void ScriptList::AddDirectory(const string& path) {
+    Source source = {Source::DIRECTORY, path};
+    sources_.push_back(source);
+}
+
+void ScriptList::AddWarc(const string& path) {
+    Source source = {Source::WARC, path};
+    sources_.push_back(source);
+}
+
+bool ScriptList::Next(string* path, string* content) {
+    content->clear();
+    while (true) {
+        if (list_ && NextInList(path))
+            return true;
+        if (!dirs_.empty() && NextInDirectory(path))
+            return true;
+        if (warc_ && NextInWarc(path, content))
+            return true;
+        if (sources_.empty())
+            return false;
+        if (sources_.front().type == Source::SCRIPT) {
+            *path = sources_.front().path;
+            sources_.pop_front();
+            return true;
+        }
+        OpenSource();
+    }
+}
+
+bool ScriptList::OpenSource() {
+    Source source = sources_.front();
+    sources_.pop_front();
+    switch (source.type) {
+        case Source::LIST:
+            if (source.path == "-") {
+                list_ = &cin;
+            } else {
+                list_ = new ifstream(source.path.c_str());
+                if (!*list_) {
+                    cerr << "Cannot open " << source.path << endl;
+                    delete list_;
+                    list_ = NULL;
+                    return false;
+                }
+            }
+            return true;
+
+        case Source::DIRECTORY:
+            PushDirectory(source.path);
+            return true;
+
+        case Source::WARC:
+            warc_ = new WarcReader;
+            if (!warc_->Open(source.path)) {
+                delete warc_;
+                warc_ = NULL;
+                return false;
+            }
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+bool ScriptList::NextInList(string* path) {
+    while (getline(*list_, *path)) {
+        if (!path->empty())
+            return true;
+    }
+    if (list_ != &cin)
+        delete list_;
+    list_ = NULL;
+    return false;
+}
+
+bool ScriptList::NextInDirectory(string* path) {
+    while (!dirs_.empty()) {
+        if (dirs_.back().empty()) {
+            dirs_.pop_back();
+            continue;
+        }
+        *path = dirs_.back().back();
+        dirs_.back().pop_back();
+        struct stat st;
+        if (lstat(path->c_str(), &st) != 0)
+            continue;
+        if (S_ISDIR(st.st_mode))
+            PushDirectory(*path);
+        else if (S_ISREG(st.st_mode))
+            return true;
+    }
+    return false;
+}
+
+bool ScriptList::NextInWarc(string* path, string* content) {
+    while (true) {
+        while (!page_scripts_.empty()) {
+            HtmlScanner::Script& script = page_scripts_.back();
+            if (seen_.insert(Hash128(script.code.data(), script.code.size())).second) {
+                ostringstream name;
+                name << page_ << '#' << script.line << ',' << script.column;
+                *path = name.str();
+                content->swap(script.code);
+                page_scripts_.pop_back();
+                return true;
+            }
+            page_scripts_.pop_back();
+        }
+
+        WarcReader::Record record;
+        if (!warc_->Next(&record))
+            break;
+        string content_type;
+        string body;
+        if (record.type != "response" || !WarcReader::ParseResponse(record.content, &content_type, &body))
+            continue;
+        if (!content_type.empty() && content_type.find("html") == string::npos)
+            continue;
+        page_ = record.uri;
+        HtmlScanner::Scan(body, &page_scripts_);
+        reverse(page_scripts_.begin(), page_scripts_.end());
+    }
+    delete warc_;
+    warc_ = NULL;
+    return false;
+}
+
+void ScriptList::PushDirectory(const string& path) {
+    DIR* dir = opendir(path.c_str());
+    if (dir == NULL) {
+        cerr << "Cannot open " << path << endl;
+        return;
+    }
+    vector<string> entries;
+    for (struct dirent* entry = readdir(dir); entry != NULL; entry = readdir(dir)) {
+        string name = entry->d_name;
+        // skip ".", ".." and the unparsable scripts set aside by extract_js.py
+        if (name == "." || name == ".." || name == ".bad")
+            continue;
+        entries.push_back(path + "/" + name);
+    }
+    closedir(dir);
+    // keep the walk reproducible across file systems
+    sort(entries.begin(), entries.end());
+    dirs_.push_back(vector<string>(entries.rbegin(), entries.rend()));
+}
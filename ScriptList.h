@@ -0,0 +1,81 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#ifndef SCRIPTLIST_H
+#define SCRIPTLIST_H
+
+#include <deque>
+#include <istream>
+#include <set>
+#include <string>
+#include <vector>
+#include "Hash.h"
+#include "HtmlScanner.h"
+#include "WarcReader.h"
+
+using std::deque;
+using std::istream;
+using std::set;
+using std::string;
+using std::vector;
+
+// Enumerates the scripts of a batch run. Sources are consumed lazily in the
+// order they are added, so a list of millions of paths, a deep crawl tree or
+// a WARC file is never held in memory at once.
+class ScriptList {
+    public:
+        ScriptList() : list_(NULL), warc_(NULL) { }
+        ~ScriptList();
+
+        // A single script path.
+        void AddFile(const string& path);
+        // A file holding one script path per line; "-" reads from stdin.
+        void AddList(const string& path);
+        // A tree written by scripts/extract_js.py; ".bad" directories are skipped.
+        void AddDirectory(const string& path);
+        // A crawl in a WARC file, optionally gzip'd. The inline scripts of its
+        // HTML responses are listed with their contents, once per distinct
+        // content, and are named <url>#<line>,<column>.
+        void AddWarc(const string& path);
+
+        // Returns the path of the next script, or its name and its contents
+        // if it does not live in a file of its own; content is left empty for
+        // a script to be read from its path.
+        bool Next(string* path, string* content);
+
+    private:
+        struct Source {
+            enum {SCRIPT, LIST, DIRECTORY, WARC} type;
+            string path;
+        };
+
+        deque<Source> sources_;
+        istream* list_;
+        vector<vector<string> > dirs_;  // stack of pending entries, reversed
+        WarcReader* warc_;
+        string page_;  // the URI of the current response
+        vector<HtmlScanner::Script> page_scripts_;  // and its pending scripts, reversed
+        set<Hash128> seen_;  // the hashes of the inline scripts listed so far
+
+        bool OpenSource();
+        bool NextInList(string* path);
+        bool NextInDirectory(string* path);
+        bool NextInWarc(string* path, string* content);
+        void PushDirectory(const string& path);
+};
+
+#endif // SCRIPTLIST_H
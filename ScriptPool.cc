@@ -0,0 +1,99 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#include "ScriptPool.h"
+
+#include <iostream>
+#include <vector>
+
+using std::cerr;
+using std::endl;
+using std::vector;
+
+ScriptPool::ScriptPool(const ScriptOptions& options, StructureCache* structures, int num_workers, bool ordered)
+    : options_(options), structures_(structures), num_workers_(num_workers), ordered_(ordered) {
+    pthread_mutex_init(&mutex_, NULL);
+    pthread_cond_init(&cond_, NULL);
+}
+
+ScriptPool::~ScriptPool() {
+    pthread_cond_destroy(&cond_);
+    pthread_mutex_destroy(&mutex_);
+}
+
+int ScriptPool::Run(ScriptList* scripts, ostream* out) {
+    OrderedOutput output(out, ordered_, 64 * num_workers_);
+    scripts_ = scripts;
+    output_ = &output;
+    next_input_ = 0;
+    next_worker_ = 0;
+    failures_ = 0;
+    // scripts are fetched one at a time, so a worker that cannot be started
+    // only leaves more of them to the others
+    vector<pthread_t> workers;
+    for (int i = 0; i < num_workers_; ++i) {
+        pthread_t worker;
+        if (pthread_create(&worker, NULL, &ScriptPool::Work, this) == 0)
+            workers.push_back(worker);
+    }
+    if (workers.empty()) {
+        cerr << "Cannot start worker threads" << endl;
+        Work(this);
+    }
+    for (size_t i = 0; i < workers.size(); ++i)
+        pthread_join(workers[i], NULL);
+    return failures_;
+}
+
+void* ScriptPool::Work(void* pool) {
+    ScriptPool* self = static_cast<ScriptPool*>(pool);
+    ScriptOptions options = self->options_;
+    pthread_mutex_lock(&self->mutex_);
+    options.worker = self->next_worker_++;
+    pthread_mutex_unlock(&self->mutex_);
+    ScriptProcessor processor(options, self->structures_);
+    string path;
+    string content;
+    string output;
+    size_t seq;
+    while (self->Fetch(&path, &content, &seq)) {
+        bool success = content.empty() ? processor.Process(path, &output) : processor.Process(path, content, &output);
+        self->Deliver(seq, output, success);
+    }
+    return NULL;
+}
+
+bool ScriptPool::Fetch(string* path, string* content, size_t* seq) {
+    pthread_mutex_lock(&mutex_);
+    // Don't run too far ahead of a slow script when the output is ordered.
+    while (output_->Full(next_input_))
+        pthread_cond_wait(&cond_, &mutex_);
+    bool fetched = scripts_->Next(path, content);
+    if (fetched)
+        *seq = next_input_++;
+    pthread_mutex_unlock(&mutex_);
+    return fetched;
+}
+
+void ScriptPool::Deliver(size_t seq, const string& output, bool success) {
+    pthread_mutex_lock(&mutex_);
+    if (!success)
+        ++failures_;
+    if (output_->Write(seq, output))
+        pthread_cond_broadcast(&cond_);
+    pthread_mutex_unlock(&mutex_);
+}
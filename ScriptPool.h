@@ -0,0 +1,62 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#ifndef SCRIPTPOOL_H
+#define SCRIPTPOOL_H
+
+#include <ostream>
+#include <pthread.h>
+#include <string>
+#include "OrderedOutput.h"
+#include "ScriptList.h"
+#include "ScriptProcessor.h"
+
+using std::ostream;
+using std::string;
+
+// Processes a list of scripts with a number of worker threads, each of which
+// owns a ScriptProcessor (and thus a V8 isolate); all of them share one
+// structure cache. Workers pull paths from the shared list one at a time. If
+// ordered, the outputs are written in the order of the list; otherwise they
+// are written as soon as they are ready.
+class ScriptPool {
+    public:
+        ScriptPool(const ScriptOptions& options, StructureCache* structures, int num_workers, bool ordered);
+        ~ScriptPool();
+
+        // Returns the number of scripts that failed.
+        int Run(ScriptList* scripts, ostream* out);
+
+    private:
+        const ScriptOptions options_;
+        StructureCache* const structures_;
+        const int num_workers_;
+        const bool ordered_;
+        ScriptList* scripts_;
+        OrderedOutput* output_;
+        pthread_mutex_t mutex_;
+        pthread_cond_t cond_;
+        size_t next_input_;
+        int next_worker_;
+        int failures_;
+
+        static void* Work(void* pool);
+        bool Fetch(string* path, string* content, size_t* seq);
+        void Deliver(size_t seq, const string& output, bool success);
+};
+
+#endif // SCRIPTPOOL_H
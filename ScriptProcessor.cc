@@ -0,0 +1,409 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#include "ScriptProcessor.h"
+
+#include <stdlib.h>
+#include <algorithm>
+#include <iostream>
+#include <ast.h>
+#include <parser.h>
+#include <api.h>
+#include <compiler.h>
+#include "CanonicalAst.h"
+#include "DependenceGraph.h"
+#include "CodePrinter.h"
+#include "ExtractorPool.h"
+#include "NgramExtractor.h"
+#include "PDGExtractor.h"
+#include "SequenceExtractor.h"
+#include "SqliteNgramWriter.h"
+#include "UnfoldingExtractor.h"
+#include "Utility.h"
+
+using std::cerr;
+using std::endl;
+using std::max;
+
+string ScriptOptions::DatabasePath() const {
+    if (!split_database)
+        return database;
+    ostringstream path;
+    path << database << '.' << worker;
+    return path.str();
+}
+
+bool ScriptOptions::Descriptions() const {
+    return type != SEQUENCE;
+}
+
+ScriptProcessor::ScriptProcessor(const ScriptOptions& options, StructureCache* structures)
+    : options_(options), isolate_(NULL), structures_(structures) {
+    if (!options_.graphs) {
+        isolate_ = v8::Isolate::New();
+        isolate_->Enter();
+        context_ = v8::Context::New();
+        context_->Enter();
+    }
+    switch (options_.format) {
+        case ScriptOptions::TEXT:
+            writer_ = new TextNgramWriter(&out_, options_.tag, options_.Descriptions(), !options_.line,
+                                          options_.n < options_.max_n);
+            break;
+
+        case ScriptOptions::BINARY:
+            writer_ = new BinaryNgramWriter(&out_);
+            break;
+
+        case ScriptOptions::SQLITE:
+            writer_ = new SqliteNgramWriter(options_.DatabasePath(), options_.Descriptions(), options_.commit_scripts);
+            break;
+    }
+    cache_ = NULL;
+    // a graph file names its script only inside, so its results are not cached
+    if (options_.mode == ScriptOptions::EXTRACT && !options_.cache_dir.empty() && !options_.graphs) {
+        // everything the records depend on besides the content
+        ostringstream key;
+        key << "v7 " << options_.type << ' ' << options_.n << ' ' << options_.max_n << ' ' << options_.line << ' '
+            << options_.size_limit << ' ' << options_.cost_limit << ' ' << options_.count_limit << ' ' << options_.refine << ' '
+            << options_.fingerprint;
+        cache_ = new ScriptCache(options_.cache_dir, key.str());
+    }
+    if (options_.mode == ScriptOptions::EXTRACT && options_.fingerprint) {
+        for (int i = 0; i < max(options_.threads, 1); ++i)
+            dictionaries_.push_back(new PatternDictionary(options_.dictionary));
+    }
+}
+
+ScriptProcessor::~ScriptProcessor() {
+    delete cache_;
+    for (vector<PatternDictionary*>::iterator i = dictionaries_.begin(); i != dictionaries_.end(); ++i)
+        delete *i;
+    delete writer_;
+    if (isolate_) {
+        context_->Exit();
+        context_.Dispose();
+        isolate_->Exit();
+        isolate_->Dispose();
+    }
+}
+
+StructureCache* ScriptProcessor::NewStructureCache(const ScriptOptions& options) {
+    if (options.mode != ScriptOptions::EXTRACT || options.type != ScriptOptions::PDG || !options.structure_cache_size)
+        return NULL;
+    // everything the search results depend on besides the structures
+    ostringstream key;
+    key << "v1 " << options.size_limit << ' ' << options.cost_limit << ' ' << options.count_limit << ' ' << options.refine;
+    StructureCache* structures = new StructureCache(options.structure_cache_size, key.str());
+    if (!options.structure_cache.empty())
+        structures->Load(options.structure_cache);
+    return structures;
+}
+
+bool ScriptProcessor::Process(const string& path, string* output) {
+    MappedScript* script = MappedScript::Open(path);
+    if (script == NULL) {
+        output->clear();
+        cerr << "Cannot open " << path << endl;
+        return false;
+    }
+    return Process(path, script->data(), script->length(), script, output);
+}
+
+bool ScriptProcessor::Process(const string& path, const string& code, string* output) {
+    return Process(path, code.data(), code.size(), NULL, output);
+}
+
+// Processes the code in data, which belongs to script if it is not NULL; the
+// script is then either handed over to V8 or deleted. Otherwise the code is
+// copied into V8.
+//
+// A cache entry is a success flag, the length in decimal and a newline, the
+// lines the script gave the dictionary side file, and the records of the
+// script as kept by a RecordingNgramWriter, so that it can be replayed in any
+// format and under any path.
+static bool SplitEntry(const string& entry, bool* success, string* patterns, string* records) {
+    size_t newline = entry.find('\n');
+    if (entry.empty() || newline == string::npos)
+        return false;
+    size_t length = strtoul(entry.c_str() + 1, NULL, 10);
+    if (length > entry.size() - newline - 1)
+        return false;
+    *success = entry[0] == '1';
+    patterns->assign(entry, newline + 1, length);
+    records->assign(entry, newline + 1 + length, string::npos);
+    return true;
+}
+
+bool ScriptProcessor::Process(const string& path, const char* data, size_t length, MappedScript* script, string* output) {
+    out_.str("");
+    Hash128 key;
+    if (cache_) {
+        key = cache_->Key(data, length);
+        string entry, patterns, records;
+        bool success;
+        if (cache_->Lookup(key, &entry) && SplitEntry(entry, &success, &patterns, &records)) {
+            delete script;
+            if (success) {
+                if (!dictionaries_.empty()) {
+                    dictionaries_[0]->Add(patterns);
+                    dictionaries_[0]->Flush();
+                }
+                writer_->BeginScript(path);
+                BinaryNgramReader::Replay(records, writer_);
+            } else {
+                cerr << "Cannot parse " << path << endl;
+            }
+            if (!writer_->EndScript()) {
+                cerr << "Cannot store the n-grams of " << path << endl;
+                success = false;
+            }
+            *output = out_.str();
+            return success;
+        }
+    }
+
+    RecordingNgramWriter recorder(writer_);
+    NgramWriter* writer = writer_;
+    vector<string> patterns(dictionaries_.size());
+    if (cache_) {
+        writer_ = &recorder;
+        for (size_t i = 0; i < dictionaries_.size(); ++i)
+            dictionaries_[i]->set_recording(&patterns[i]);
+    }
+    bool success;
+    if (options_.graphs) {
+        success = LoadGraph(path, data, length);
+        delete script;
+    } else {
+        v8::HandleScope handle_scope;
+        success = Analyze(path, script ? MappedScript::ToString(script) : v8::String::New(data, static_cast<int>(length)));
+    }
+    writer_ = writer;
+    const bool stored = writer_->EndScript();
+    if (!stored)
+        cerr << "Cannot store the n-grams of " << path << endl;
+    for (vector<PatternDictionary*>::iterator i = dictionaries_.begin(); i != dictionaries_.end(); ++i) {
+        (*i)->set_recording(NULL);
+        (*i)->Flush();
+    }
+    if (cache_) {
+        string lines;
+        for (vector<string>::iterator i = patterns.begin(); i != patterns.end(); ++i)
+            lines += *i;
+        ostringstream entry;
+        entry << (success ? '1' : '0') << lines.size() << '\n' << lines << recorder.records();
+        cache_->Store(key, entry.str());
+    }
+    *output = out_.str();
+    return success && stored;
+}
+
+bool ScriptProcessor::Analyze(const string& path, v8::Handle<v8::String> source) {
+    Isolate* isolate = reinterpret_cast<Isolate*>(isolate_);
+    HandleScope handle_scope(isolate);
+    // Everything below is allocated in the runtime zone, which is reset once
+    // the script is done so that the next one starts from an empty zone.
+    ZoneScope zone_scope(isolate->runtime_zone(), DELETE_ON_EXIT);
+    Handle<Script> script = isolate->factory()->NewScript(v8::Utils::OpenHandle(*source));
+    CompilationInfo info(script, isolate->runtime_zone());
+    info.MarkAsGlobal();
+    if (!ParserApi::Parse(&info, kNoParsingFlags)) {
+        cerr << "Cannot parse " << path << endl;
+        return false;
+    }
+    if (info.function()->ast_node_count() == 0) {
+        cerr << "Cannot parse " << path << endl;
+        return false;
+    }
+    if (!Scope::Analyze(&info)) {
+        cerr << "Cannot parse " << path << endl;
+        return false;
+    }
+
+    CanonicalAstConverter(isolate).Convert(&info);
+    DependenceGraphBuilder builder;
+    builder.Build(info.function());
+    const DependenceGraph& graph = builder.GetGraph();
+    CodePrinter printer(info.function(), graph);
+    GraphFile file(graph, printer);
+
+    const int n = options_.n;
+    const string tag = options_.tag ? path + '\t' : "";
+    int node = options_.line ? printer.GetLine(options_.line) : -1;
+
+    switch (options_.mode) {
+        case ScriptOptions::EXTRACT:
+            Extract(path, &file);
+            if (writer_->WantsFunctions()) {
+                for (key_iterator<const map<int,Statement*> > i = printer.GetFuncList().begin(); i != printer.GetFuncList().end(); ++i) {
+                    CanonicalFunctionEntry* function = (CanonicalFunctionEntry*)graph.statement(printer.GetLine(*i));
+                    writer_->WriteFunction(*i, printer.PrintFunc(function->literal()));
+                }
+            }
+            break;
+
+        case ScriptOptions::DUMP:
+            if (!file.Save(options_.graph_dir, path)) {
+                cerr << "Cannot save the graph of " << path << endl;
+                return false;
+            }
+            break;
+
+        case ScriptOptions::PRINT:
+            if (node >= 0) {
+                CanonicalFunctionEntry* function = (CanonicalFunctionEntry*)graph.statement(printer.GetLine(printer.GetFuncNo(node)));
+                NeighborhoodGrower neighborhood(graph);
+                neighborhood.Reset(node);
+                neighborhood.Grow(n);
+                printer.Print(function->literal(), &neighborhood);
+            }
+            if (options_.tag)
+                out_ << "// " << path << '\n';
+            out_ << printer.GetOutput();
+            break;
+
+/*
+        case DEPEND:
+            if (node) {
+                DependenceGraph neighborhood1 = extractor.FindNeighborhood(node, n);
+                for (list<Statement*>::const_iterator j = builder.GetGraph().at(node).begin(); j != builder.GetGraph().at(node).end(); ++j) {
+                    const DependenceGraph& neighborhood2 = extractor.FindNeighborhood(*j, n);
+                    int weight = 0;
+                    for (key_iterator<DependenceGraph> l = neighborhood1.begin(); l != neighborhood1.end(); ++l)
+                        weight += 1 - neighborhood2.count(*l);
+                    for (key_iterator<DependenceGraph> l = neighborhood2.begin(); l != neighborhood2.end(); ++l)
+                        weight += 1 - neighborhood1.count(*l);
+                    cout << printer.GetLineNo(node) << " " << printer.GetLineNo(*j) << " " << weight << endl;
+                }
+            } else {
+                map<Statement*,set<Statement*> > neighbors;
+                for (key_iterator<DependenceGraph> i = builder.GetGraph().begin(); i != builder.GetGraph().end(); ++i) {
+                    const DependenceGraph& neighborhood = extractor.FindNeighborhood(*i, n);
+                    for (key_iterator<DependenceGraph> j = neighborhood.begin(); j != neighborhood.end(); ++j)
+                        neighbors[*i].insert(*j);
+                }
+                for (DependenceGraph::const_iterator i = builder.GetGraph().begin(); i != builder.GetGraph().end(); ++i) {
+                    for (list<Statement*>::const_iterator j = i->second.begin(); j != i->second.end(); ++j) {
+                        int weight = 0;
+                        for (set<Statement*>::iterator l = neighbors[i->first].begin(); l != neighbors[i->first].end(); ++l)
+                            weight += 1 - neighbors[*j].count(*l);
+                        for (set<Statement*>::iterator l = neighbors[*j].begin(); l != neighbors[*j].end(); ++l)
+                            weight += 1 - neighbors[i->first].count(*l);
+                        cout << printer.GetLineNo(i->first) << " " << printer.GetLineNo(*j) << " " << weight << endl;
+                    }
+                }
+            }
+            break;
+*/
+
+        case ScriptOptions::LIST:
+            for (key_iterator<const map<int,Statement*> > i =  printer.GetFuncList().begin(); i != printer.GetFuncList().end(); ++i) {
+                out_ << tag << *i << " ";
+                CanonicalFunctionEntry* function = (CanonicalFunctionEntry*)graph.statement(printer.GetLine(*i));
+                printer.PrintFunc(function->literal());
+                out_ << printer.GetOutput() << '\n';
+            }
+    }
+    return true;
+}
+
+// Extracts the n-grams of a graph file saved by DUMP, under the path of the
+// script it was saved from.
+bool ScriptProcessor::LoadGraph(const string& path, const char* data, size_t length) {
+    GraphFile* file = GraphFile::Load(data, length);
+    if (file == NULL) {
+        cerr << "Cannot load " << path << endl;
+        return false;
+    }
+    Extract(file->path(), file);
+    delete file;
+    return true;
+}
+
+void ScriptProcessor::Extract(const string& path, GraphFile* file) {
+    const DependenceGraph& graph = file->graph();
+
+    // every thread extracting the lines gets its own extractor over the graph
+    vector<NgramExtractor*> extractors;
+    vector<PDGExtractor*> pdg_extractors;
+    const int num_threads = !options_.line ? max(options_.threads, 1) : 1;
+    switch (options_.type) {
+        case ScriptOptions::PDG:
+            for (int i = 0; i < num_threads; ++i) {
+                PDGExtractor *pdg_extractor = new PDGExtractor(graph, mem_fun_less(file, &GraphFile::CompareNode),
+                                                               options_.size_limit, options_.cost_limit, options_.count_limit,
+                                                               options_.refine);
+                pdg_extractor->set_structure_cache(structures_);
+                pdg_extractors.push_back(pdg_extractor);
+                extractors.push_back(pdg_extractor);
+            }
+            break;
+
+        case ScriptOptions::SEQUENCE:
+            extractors.push_back(new SequenceExtractor(graph, mem_fun_less(file, &GraphFile::CompareNode)));
+            break;
+
+        case ScriptOptions::UNFOLDING:
+            extractors.push_back(new UnfoldingExtractor(graph, mem_fun_less(file, &GraphFile::CompareNode)));
+            break;
+    }
+    for (size_t i = 0; i < extractors.size() && i < dictionaries_.size(); ++i)
+        extractors[i]->set_dictionary(dictionaries_[i]);
+    NgramExtractor *extractor = extractors[0];
+
+    const int n = options_.n;
+    int node = options_.line ? file->GetLine(options_.line) : -1;
+
+    writer_->BeginScript(path);
+    if (node >= 0) {
+        for (int k = n; k <= options_.max_n; ++k) {
+            Ngram ngram;
+            extractor->Extract(node, k, true, &ngram);
+            if (ngram.pattern == "") {
+                ngram.pattern = NgramExtractor::StatusName(extractor->status());
+                cerr << "Cannot extract " << k << "-gram for " << path << ":" << options_.line << endl;
+            }
+            writer_->Write(options_.line, file->GetFuncNo(node), k, ngram);
+        }
+    } else {
+        // every line holds a statement of the graph, as the printer numbers no other
+        vector<int> nodes;
+        for (size_t i = 1; i <= file->NumLines(); ++i)
+            nodes.push_back(file->GetLine(i));
+        vector<Ngram> ngrams;
+        ExtractorPool(extractors).Run(nodes, n, options_.max_n, &ngrams);
+        vector<Ngram>::iterator ngram = ngrams.begin();
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            for (int k = n; k <= options_.max_n; ++k)
+                writer_->Write(i + 1, file->GetFuncNo(nodes[i]), k, *ngram++);
+        }
+    }
+    if (options_.verbose && !pdg_extractors.empty()) {
+        size_t orders = 0, cuts = 0, reuses = 0;
+        for (vector<PDGExtractor*>::iterator i = pdg_extractors.begin(); i != pdg_extractors.end(); ++i) {
+            orders += (*i)->orders();
+            cuts += (*i)->cuts();
+            reuses += (*i)->reuses();
+        }
+        cerr << path << ": " << orders << " orders searched, " << cuts << " cut off, " << reuses
+             << " searches reused" << endl;
+    }
+
+    for (vector<NgramExtractor*>::iterator i = extractors.begin(); i != extractors.end(); ++i)
+        delete *i;
+}
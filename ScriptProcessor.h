@@ -0,0 +1,111 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#ifndef SCRIPTPROCESSOR_H
+#define SCRIPTPROCESSOR_H
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include <v8.h>
+#include "GraphFile.h"
+#include "MappedScript.h"
+#include "NgramWriter.h"
+#include "PatternDictionary.h"
+#include "ScriptCache.h"
+#include "StructureCache.h"
+
+using std::ostringstream;
+using std::string;
+using std::vector;
+
+struct ScriptOptions {
+    enum {EXTRACT, PRINT, LIST, DUMP} mode;
+    enum {PDG, SEQUENCE, UNFOLDING} type;
+    enum {TEXT, BINARY, SQLITE} format;  // of extracted n-grams
+    int n;  // depth of n-grams, or the smallest one of a range
+    int max_n;  // the largest depth of a range
+    int line;  // focal line, 0 for all lines
+    bool tag;  // prefix every record with the script path
+    size_t size_limit;  // see PDGExtractor
+    size_t cost_limit;
+    size_t count_limit;
+    bool refine;  // canonical labeling by partition refinement (see CanonicalLabeler)
+    string database;  // for the SQLite format
+    bool split_database;  // give every worker its own database <database>.<worker>
+    int worker;  // index of the worker thread or process running the processor
+    bool commit_scripts;  // make the records of every script durable once it is done, as a worker may be killed
+    string cache_dir;  // where extraction results are cached, if not empty
+    bool verbose;  // report search statistics of every script
+    bool fingerprint;  // output fingerprints of the patterns instead of the patterns
+    string dictionary;  // side file of the patterns behind the fingerprints, if not empty
+    size_t structure_cache_size;  // bytes of search results kept by a PDG extraction, 0 for none
+    string structure_cache;  // file the search results are loaded from and saved to, if not empty
+    int threads;  // extracting the lines of a script with PDG extractors
+    string graph_dir;  // where DUMP saves the graphs of the scripts
+    bool graphs;  // the scripts given are graph files saved by DUMP, to be extracted without parsing
+
+    ScriptOptions() : mode(EXTRACT), type(PDG), format(TEXT), n(3), max_n(3), line(0), tag(false), size_limit(40), cost_limit(0), count_limit(0),
+                      refine(false), split_database(false), worker(0), commit_scripts(false), verbose(false),
+                      fingerprint(false), structure_cache_size(0), threads(1), graphs(false) { }
+
+    string DatabasePath() const;
+    // Whether the extracted n-grams come with long descriptions.
+    bool Descriptions() const;
+};
+
+// Runs the whole parse-canonicalize-extract pipeline on one script at a time.
+// A processor owns a V8 isolate and a single context in it that is reused for
+// every script it is given; all AST memory of a script lives in the runtime
+// zone and is released before the next one is parsed. A processor must be
+// created, used and destroyed by the same thread. A processor of graph files
+// runs no V8 at all.
+//
+// The search results of PDG extraction go to a structure cache that may be
+// shared by any number of processors and outlives them.
+class ScriptProcessor {
+    public:
+        ScriptProcessor(const ScriptOptions& options, StructureCache* structures);
+        ~ScriptProcessor();
+
+        // Returns the structure cache the options ask for, loaded from
+        // options.structure_cache, or NULL if they ask for none.
+        static StructureCache* NewStructureCache(const ScriptOptions& options);
+
+        // Processes the script at path. The records are stored into output,
+        // which is valid until the next call.
+        bool Process(const string& path, string* output);
+        // Processes a script held in memory; path only names it.
+        bool Process(const string& path, const string& code, string* output);
+
+    private:
+        const ScriptOptions options_;
+        v8::Isolate* isolate_;
+        v8::Persistent<v8::Context> context_;
+        ostringstream out_;
+        NgramWriter* writer_;
+        ScriptCache* cache_;
+        vector<PatternDictionary*> dictionaries_;  // one for every thread
+        StructureCache* const structures_;
+
+        bool Process(const string& path, const char* data, size_t length, MappedScript* script, string* output);
+        bool Analyze(const string& path, v8::Handle<v8::String> source);
+        bool LoadGraph(const string& path, const char* data, size_t length);
+        void Extract(const string& path, GraphFile* file);
+};
+
+#endif // SCRIPTPROCESSOR_H
@@ -0,0 +1,282 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#include "ScriptSupervisor.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <poll.h>
+#include <sstream>
+#include <signal.h>
+#include <stdint.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <v8.h>
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::max;
+using std::ostringstream;
+
+static double Now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static bool WriteAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+ScriptSupervisor::ScriptSupervisor(const ScriptOptions& options, StructureCache* structures, int num_workers, int time_limit,
+                                   bool ordered)
+    : options_(options), structures_(structures), time_limit_(time_limit), ordered_(ordered), workers_(num_workers) {
+}
+
+int ScriptSupervisor::Run(ScriptList* scripts, ostream* out) {
+    OrderedOutput output(out, ordered_, 64 * workers_.size());
+    // A dead worker must not take the supervisor down with it.
+    signal(SIGPIPE, SIG_IGN);
+    for (size_t i = 0; i < workers_.size(); ++i)
+        Spawn(&workers_[i]);
+
+    int failures = 0;
+    size_t next_seq = 0;
+    bool more = true;
+    vector<struct pollfd> fds;
+    vector<Worker*> polled;
+    while (true) {
+        // hand out scripts to idle workers
+        for (size_t i = 0; i < workers_.size() && more && !output.Full(next_seq); ++i) {
+            Worker* worker = &workers_[i];
+            if (worker->busy)
+                continue;
+            string path;
+            string content;
+            if (!scripts->Next(&path, &content)) {
+                more = false;
+                break;
+            }
+            if (!Assign(worker, path, content, next_seq)) {
+                Reap(worker, "died");
+                output.Write(next_seq, "");
+                ++failures;
+                Spawn(worker);
+            }
+            ++next_seq;
+        }
+
+        fds.clear();
+        polled.clear();
+        double deadline = 0;
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            if (!workers_[i].busy)
+                continue;
+            struct pollfd fd = {workers_[i].result_fd, POLLIN, 0};
+            fds.push_back(fd);
+            polled.push_back(&workers_[i]);
+            if (time_limit_ && (deadline == 0 || workers_[i].deadline < deadline))
+                deadline = workers_[i].deadline;
+        }
+        if (fds.empty()) {
+            if (!more)
+                break;
+            continue;
+        }
+
+        int timeout = -1;
+        if (deadline != 0)
+            timeout = max(0, static_cast<int>((deadline - Now()) * 1000) + 1);
+        if (poll(&fds[0], fds.size(), timeout) < 0 && errno != EINTR) {
+            perror("poll");
+            break;
+        }
+
+        double now = Now();
+        for (size_t i = 0; i < fds.size(); ++i) {
+            Worker* worker = polled[i];
+            if (fds[i].revents) {
+                string result;
+                bool success;
+                switch (Receive(worker, &result, &success)) {
+                    case 1:
+                        output.Write(worker->seq, result);
+                        if (!success)
+                            ++failures;
+                        worker->busy = false;
+                        continue;
+                    case -1:
+                        Reap(worker, "crashed");
+                        output.Write(worker->seq, "");
+                        ++failures;
+                        Spawn(worker);
+                        continue;
+                }
+            }
+            if (time_limit_ && now >= worker->deadline) {
+                kill(worker->pid, SIGKILL);
+                Reap(worker, "timed out");
+                output.Write(worker->seq, "");
+                ++failures;
+                Spawn(worker);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        close(workers_[i].task_fd);
+        close(workers_[i].result_fd);
+        waitpid(workers_[i].pid, NULL, 0);
+    }
+    return failures;
+}
+
+void ScriptSupervisor::Spawn(Worker* worker) {
+    int task[2];
+    int result[2];
+    if (pipe(task) != 0 || pipe(result) != 0) {
+        perror("pipe");
+        exit(1);
+    }
+    // Nothing buffered in the parent may be written twice.
+    cout.flush();
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        exit(1);
+    }
+    if (pid == 0) {
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            if (&workers_[i] != worker && workers_[i].pid > 0) {
+                close(workers_[i].task_fd);
+                close(workers_[i].result_fd);
+            }
+        }
+        close(task[1]);
+        close(result[0]);
+        // A replacement worker carries on with the database of its slot.
+        ScriptOptions options = options_;
+        options.worker = worker - &workers_[0];
+        Serve(options, structures_, task[0], result[1]);
+        _exit(0);
+    }
+    close(task[0]);
+    close(result[1]);
+    worker->pid = pid;
+    worker->task_fd = task[1];
+    worker->result_fd = result[0];
+    worker->busy = false;
+    worker->buffer.clear();
+}
+
+void ScriptSupervisor::Reap(Worker* worker, const char* reason) {
+    close(worker->task_fd);
+    close(worker->result_fd);
+    int status = 0;
+    waitpid(worker->pid, &status, 0);
+    cerr << "Worker " << worker->pid << " " << reason;
+    if (WIFSIGNALED(status))
+        cerr << " (signal " << WTERMSIG(status) << ")";
+    cerr << " on " << worker->path << endl;
+    worker->pid = 0;
+}
+
+// A task is a line "<size> <path>" followed by size bytes of code, or by
+// nothing if the size is 0 and the code is to be read from path.
+bool ScriptSupervisor::Assign(Worker* worker, const string& path, const string& content, size_t seq) {
+    worker->busy = true;
+    worker->seq = seq;
+    worker->path = path;
+    worker->deadline = Now() + time_limit_;
+    worker->buffer.clear();
+    ostringstream task;
+    task << content.size() << ' ' << path << '\n';
+    string line = task.str();
+    return WriteAll(worker->task_fd, line.data(), line.size()) &&
+           WriteAll(worker->task_fd, content.data(), content.size());
+}
+
+// Returns 1 if a whole output is received, 0 if more is to come, or -1 if the
+// worker is gone.
+int ScriptSupervisor::Receive(Worker* worker, string* output, bool* success) {
+    char buf[65536];
+    ssize_t n = read(worker->result_fd, buf, sizeof(buf));
+    if (n < 0)
+        return errno == EINTR || errno == EAGAIN ? 0 : -1;
+    if (n == 0)
+        return -1;
+    worker->buffer.append(buf, n);
+    uint32_t header[2];
+    if (worker->buffer.size() < sizeof(header))
+        return 0;
+    memcpy(header, worker->buffer.data(), sizeof(header));
+    if (worker->buffer.size() < sizeof(header) + header[0])
+        return 0;
+    output->assign(worker->buffer, sizeof(header), header[0]);
+    *success = header[1];
+    worker->buffer.clear();
+    return 1;
+}
+
+void ScriptSupervisor::Serve(const ScriptOptions& options, StructureCache* structures, int task_fd, int result_fd) {
+    FILE* tasks = fdopen(task_fd, "r");
+    v8::V8::Initialize();
+    {
+        ScriptProcessor processor(options, structures);
+        char* line = NULL;
+        size_t capacity = 0;
+        ssize_t length;
+        string output;
+        string code;
+        while ((length = getline(&line, &capacity, tasks)) > 0) {
+            if (line[length - 1] == '\n')
+                line[--length] = '\0';
+            char* path;
+            size_t size = strtoul(line, &path, 10);
+            if (*path++ != ' ')
+                break;
+            code.resize(size);
+            if (size > 0 && fread(&code[0], 1, size, tasks) != size)
+                break;
+            uint32_t header[2];
+            header[1] = size > 0 ? processor.Process(path, code, &output) : processor.Process(path, &output);
+            header[0] = output.size();
+            if (!WriteAll(result_fd, reinterpret_cast<char*>(header), sizeof(header)) ||
+                !WriteAll(result_fd, output.data(), output.size()))
+                break;
+        }
+        free(line);
+    }
+    v8::V8::Dispose();
+    fclose(tasks);
+    close(result_fd);
+}
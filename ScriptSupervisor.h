@@ -0,0 +1,76 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#ifndef SCRIPTSUPERVISOR_H
+#define SCRIPTSUPERVISOR_H
+
+#include <ostream>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+#include "OrderedOutput.h"
+#include "ScriptList.h"
+#include "ScriptProcessor.h"
+
+using std::ostream;
+using std::string;
+using std::vector;
+
+// Processes a list of scripts with a number of pre-forked worker processes.
+// The supervisor hands one script at a time to an idle worker through a pipe
+// and reads the output back through another. A worker that crashes, or that
+// takes longer than the time limit on a single script, is killed and replaced
+// by a fresh one; the offending path is logged and the run goes on.
+//
+// The supervisor itself never touches V8, so workers must be spawned before
+// V8 is initialized in the parent. Every worker starts from a copy of the
+// structure cache of the parent; what it adds there stays in the worker.
+class ScriptSupervisor {
+    public:
+        ScriptSupervisor(const ScriptOptions& options, StructureCache* structures, int num_workers, int time_limit, bool ordered);
+
+        // Returns the number of scripts that failed.
+        int Run(ScriptList* scripts, ostream* out);
+
+    private:
+        struct Worker {
+            Worker() : pid(0), task_fd(-1), result_fd(-1), busy(false) { }
+
+            pid_t pid;
+            int task_fd;    // paths to the worker
+            int result_fd;  // outputs from the worker
+            bool busy;
+            size_t seq;
+            string path;
+            double deadline;
+            string buffer;
+        };
+
+        const ScriptOptions options_;
+        StructureCache* const structures_;
+        const int time_limit_;  // in seconds, 0 for no limit
+        const bool ordered_;
+        vector<Worker> workers_;
+
+        void Spawn(Worker* worker);
+        void Reap(Worker* worker, const char* reason);
+        bool Assign(Worker* worker, const string& path, const string& content, size_t seq);
+        int Receive(Worker* worker, string* output, bool* success);
+        static void Serve(const ScriptOptions& options, StructureCache* structures, int task_fd, int result_fd);
+};
+
+#endif // SCRIPTSUPERVISOR_H
@@ -19,14 +19,15 @@
 
 using std::max;
 
-string SequenceExtractor::Extract(Statement* node, int n, bool long_desc) {
+void SequenceExtractor::Extract(int node, int n, bool long_desc, Ngram* ngram) {
     string pattern;
 
     int index = index_[node];
     int i = max(0, index - n + 1);
-    pattern = Serialize(sequence_[i++]);
+    pattern = graph_.op(sequence_[i++]);
     while (i <= index)
-        pattern += " " + Serialize(sequence_[i++]);
+        pattern += " " + graph_.op(sequence_[i++]);
 
-    return pattern;
+    *ngram = Ngram();
+    ngram->pattern = Output(pattern);
 }
@@ -19,31 +19,35 @@
 #define SEQUENCEEXTRACTOR_H
 
 #include <algorithm>
-#include <map>
 #include <string>
 #include <vector>
+#include "DependenceGraph.h"
 #include "NgramExtractor.h"
 
-using std::map;
 using std::sort;
 using std::string;
 using std::vector;
 
 class SequenceExtractor : public NgramExtractor {
     public:
-        template <class Iterator, class Compare> SequenceExtractor(Iterator begin, Iterator end, Compare cmp) {
-            while (begin != end)
-                sequence_.push_back(*begin++);
+        // The statements of graph are ordered by cmp, which compares ids.
+        template <class Compare> SequenceExtractor(const DependenceGraph& graph, Compare cmp)
+            : graph_(graph), index_(graph.size()) {
+            for (int i = 0; i < graph.size(); ++i)
+                sequence_.push_back(i);
             sort(sequence_.begin(), sequence_.end(), cmp);
             for (size_t i = 0; i < sequence_.size(); ++i)
                 index_[sequence_[i]] = i;
         }
 
-        string Extract(Statement* node, int n, bool long_desc = false);
+        // There is no long description.
+        using NgramExtractor::Extract;
+        void Extract(int node, int n, bool long_desc, Ngram* ngram);
 
     private:
-        vector<Statement*> sequence_;
-        map<Statement*,int> index_;
+        const DependenceGraph& graph_;
+        vector<int> sequence_;  // ids
+        vector<int> index_;  // in sequence_, by id
 };
 
 #endif // SEQUENCEEXTRACTOR_H
@@ -0,0 +1,153 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#include "SqliteNgramWriter.h"
+
+#include <iostream>
+
+using std::cerr;
+using std::endl;
+
+static const char kSchema[] =
+    "CREATE TABLE IF NOT EXISTS scripts (id INTEGER PRIMARY KEY, path TEXT NOT NULL);"
+    "CREATE TABLE IF NOT EXISTS functions (script INTEGER NOT NULL, line INTEGER NOT NULL, signature TEXT);"
+    "CREATE TABLE IF NOT EXISTS ngrams (script INTEGER NOT NULL, line INTEGER NOT NULL, func INTEGER NOT NULL, n INTEGER NOT NULL, pattern TEXT NOT NULL,"
+    " size INTEGER, op TEXT, context TEXT);";
+
+SqliteNgramWriter::SqliteNgramWriter(const string& path, bool descriptions, bool commit_scripts)
+    : db_(Open(path)), insert_script_(NULL), insert_function_(NULL), insert_ngram_(NULL), descriptions_(descriptions),
+      commit_scripts_(commit_scripts), script_(0), in_script_(false), failed_(false), rows_(0) {
+    if (!db_)
+        return;
+    sqlite3_prepare_v2(db_, "INSERT INTO scripts (path) VALUES (?)", -1, &insert_script_, NULL);
+    sqlite3_prepare_v2(db_, "INSERT INTO functions VALUES (?, ?, ?)", -1, &insert_function_, NULL);
+    sqlite3_prepare_v2(db_, "INSERT INTO ngrams VALUES (?, ?, ?, ?, ?, ?, ?, ?)", -1, &insert_ngram_, NULL);
+    Execute("BEGIN");
+}
+
+SqliteNgramWriter::~SqliteNgramWriter() {
+    if (!db_)
+        return;
+    Execute("COMMIT");
+    sqlite3_finalize(insert_script_);
+    sqlite3_finalize(insert_function_);
+    sqlite3_finalize(insert_ngram_);
+    sqlite3_close(db_);
+}
+
+bool SqliteNgramWriter::Prepare(const string& path) {
+    sqlite3* db = Open(path);
+    if (!db)
+        return false;
+    sqlite3_close(db);
+    return true;
+}
+
+sqlite3* SqliteNgramWriter::Open(const string& path) {
+    sqlite3* db = NULL;
+    if (sqlite3_open(path.c_str(), &db) != SQLITE_OK ||
+        sqlite3_busy_timeout(db, 600000) != SQLITE_OK ||
+        sqlite3_exec(db, "PRAGMA synchronous = OFF", NULL, NULL, NULL) != SQLITE_OK ||
+        sqlite3_exec(db, kSchema, NULL, NULL, NULL) != SQLITE_OK) {
+        cerr << "Cannot open database " << path << ": " << sqlite3_errmsg(db) << endl;
+        sqlite3_close(db);
+        return NULL;
+    }
+    return db;
+}
+
+// Every script is inserted under a savepoint, so that its rows can be rolled
+// back without the other scripts of the transaction.
+void SqliteNgramWriter::BeginScript(const string& path) {
+    if (!db_)
+        return;
+    in_script_ = true;
+    failed_ = !Execute("SAVEPOINT script");
+    if (failed_)
+        return;
+    sqlite3_bind_text(insert_script_, 1, path.data(), path.size(), SQLITE_TRANSIENT);
+    failed_ = !Step(insert_script_);
+    script_ = sqlite3_last_insert_rowid(db_);
+    ++rows_;
+}
+
+bool SqliteNgramWriter::EndScript() {
+    if (!db_)
+        return false;
+    if (in_script_) {
+        in_script_ = false;
+        if (failed_)
+            Execute("ROLLBACK TO script");
+        if (!Execute("RELEASE script"))
+            failed_ = true;
+    }
+    if (rows_ > 0 && (commit_scripts_ || rows_ >= kBatchRows)) {
+        if (!Execute("COMMIT")) {
+            Execute("ROLLBACK");
+            failed_ = true;
+        }
+        Execute("BEGIN");
+        rows_ = 0;
+    }
+    bool stored = !failed_;
+    failed_ = false;
+    return stored;
+}
+
+void SqliteNgramWriter::WriteFunction(int line, const string& signature) {
+    if (!db_ || failed_)
+        return;
+    sqlite3_bind_int64(insert_function_, 1, script_);
+    sqlite3_bind_int(insert_function_, 2, line);
+    sqlite3_bind_text(insert_function_, 3, signature.data(), signature.size(), SQLITE_STATIC);
+    failed_ = !Step(insert_function_);
+    ++rows_;
+}
+
+void SqliteNgramWriter::Write(size_t line, int func, int n, const Ngram& ngram) {
+    if (!db_ || failed_)
+        return;
+    sqlite3_bind_int64(insert_ngram_, 1, script_);
+    sqlite3_bind_int64(insert_ngram_, 2, line);
+    sqlite3_bind_int(insert_ngram_, 3, func);
+    sqlite3_bind_int(insert_ngram_, 4, n);
+    sqlite3_bind_text(insert_ngram_, 5, ngram.pattern.data(), ngram.pattern.size(), SQLITE_STATIC);
+    if (descriptions_) {
+        sqlite3_bind_int64(insert_ngram_, 6, ngram.size);
+        sqlite3_bind_text(insert_ngram_, 7, ngram.op.data(), ngram.op.size(), SQLITE_STATIC);
+        sqlite3_bind_text(insert_ngram_, 8, ngram.context.data(), ngram.context.size(), SQLITE_STATIC);
+    }
+    failed_ = !Step(insert_ngram_);
+    ++rows_;
+}
+
+bool SqliteNgramWriter::Execute(const char* sql) {
+    if (sqlite3_exec(db_, sql, NULL, NULL, NULL) != SQLITE_OK) {
+        cerr << "Cannot execute " << sql << ": " << sqlite3_errmsg(db_) << endl;
+        return false;
+    }
+    return true;
+}
+
+bool SqliteNgramWriter::Step(sqlite3_stmt* stmt) {
+    bool done = sqlite3_step(stmt) == SQLITE_DONE;
+    if (!done)
+        cerr << "Cannot insert: " << sqlite3_errmsg(db_) << endl;
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    return done;
+}
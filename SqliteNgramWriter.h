@@ -0,0 +1,76 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#ifndef SQLITENGRAMWRITER_H
+#define SQLITENGRAMWRITER_H
+
+#include <sqlite3.h>
+#include <string>
+#include "NgramWriter.h"
+
+using std::string;
+
+// Writes n-grams straight into a SQLite database with the tables
+//   scripts(id, path)
+//   functions(script, line, signature)
+//   ngrams(script, line, func, n, pattern, size, op, context)
+// Rows are inserted through prepared statements in large transactions, which
+// are only committed between scripts, so a script is either stored as a whole
+// or not at all. The rows of a script that fail to go in are rolled back
+// together. A writer that may be killed commits after every script instead,
+// so that the scripts it has finished are never lost; otherwise a commit that
+// fails loses the earlier scripts of its transaction too. Several writers may
+// share a database, but they serialize on its lock; giving each its own file
+// and merging them later is faster.
+class SqliteNgramWriter : public NgramWriter {
+    public:
+        // Without descriptions, the size, op and context of every n-gram
+        // are left NULL.
+        SqliteNgramWriter(const string& path, bool descriptions, bool commit_scripts);
+        virtual ~SqliteNgramWriter();
+
+        // Creates the tables if they do not exist yet. Returns false if the
+        // database cannot be opened.
+        static bool Prepare(const string& path);
+
+        virtual void BeginScript(const string& path);
+        virtual bool EndScript();
+        virtual void WriteFunction(int line, const string& signature);
+        virtual void Write(size_t line, int func, int n, const Ngram& ngram);
+
+        virtual bool WantsFunctions() const { return true; }
+
+    private:
+        static const int kBatchRows = 100000;
+
+        sqlite3* db_;
+        sqlite3_stmt* insert_script_;
+        sqlite3_stmt* insert_function_;
+        sqlite3_stmt* insert_ngram_;
+        const bool descriptions_;
+        const bool commit_scripts_;  // commit after every script
+        sqlite3_int64 script_;
+        bool in_script_;  // between BeginScript and EndScript
+        bool failed_;  // a row of the current script did not go in
+        int rows_;  // since the last commit
+
+        static sqlite3* Open(const string& path);
+        bool Execute(const char* sql);
+        bool Step(sqlite3_stmt* stmt);
+};
+
+#endif // SQLITENGRAMWRITER_H
@@ -27,7 +27,7 @@ using std::map;
 
 class StatementCopier : public AstVisitor {
 	public:
-		StatementCopier() : isolate_(Isolate::Current()), factory_(isolate_, isolate_->runtime_zone()) { }
+		explicit StatementCopier(Isolate* isolate) : isolate_(isolate), factory_(isolate_, isolate_->runtime_zone()) { }
 
 		inline void Visit(AstNode* node) { node->Accept(this); }
 #define DECLARE_VISIT(type) \
@@ -0,0 +1,139 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#include "StructureCache.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+using std::make_pair;
+
+static const char kMagic[] = "jsgram structures 1\n";
+
+StructureCache::StructureCache(size_t capacity, const string& options)
+    : capacity_(capacity), options_(options), size_(0) {
+    pthread_mutex_init(&mutex_, NULL);
+}
+
+StructureCache::~StructureCache() {
+    pthread_mutex_destroy(&mutex_);
+}
+
+bool StructureCache::Lookup(const string& structure, int* status, string* pattern) {
+    Hash128 key(structure.data(), structure.size());
+    pthread_mutex_lock(&mutex_);
+    map<Hash128,list<Entry>::iterator>::iterator i = index_.find(key);
+    bool found = i != index_.end() && i->second->structure == structure;
+    if (found) {
+        entries_.splice(entries_.begin(), entries_, i->second);
+        *status = i->second->status;
+        *pattern = i->second->pattern;
+    }
+    pthread_mutex_unlock(&mutex_);
+    return found;
+}
+
+void StructureCache::Store(const string& structure, int status, const string& pattern) {
+    Entry entry;
+    entry.key = Hash128(structure.data(), structure.size());
+    entry.structure = structure;
+    entry.status = status;
+    entry.pattern = pattern;
+    if (Cost(entry) > capacity_)
+        return;
+    pthread_mutex_lock(&mutex_);
+    map<Hash128,list<Entry>::iterator>::iterator i = index_.find(entry.key);
+    if (i != index_.end()) {
+        size_ -= Cost(*i->second);
+        entries_.erase(i->second);
+        index_.erase(i);
+    }
+    entries_.push_front(entry);
+    index_.insert(make_pair(entry.key, entries_.begin()));
+    size_ += Cost(entry);
+    while (size_ > capacity_) {
+        size_ -= Cost(entries_.back());
+        index_.erase(entries_.back().key);
+        entries_.pop_back();
+    }
+    pthread_mutex_unlock(&mutex_);
+}
+
+// The file holds the magic line and the options on a line, followed by the
+// entries from the least recently used one on, each as a line of its status
+// and the lengths of its structure and pattern followed by both.
+bool StructureCache::Load(const string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    string data;
+    char buf[65536];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0)
+        data.append(buf, n);
+    close(fd);
+    const string header = kMagic + options_ + '\n';
+    if (n != 0 || data.compare(0, header.size(), header) != 0)
+        return false;
+    size_t pos = header.size();
+    while (pos < data.size()) {
+        size_t end = data.find('\n', pos);
+        int status;
+        unsigned long structure_size, pattern_size;
+        if (end == string::npos || sscanf(data.c_str() + pos, "%d %lu %lu", &status, &structure_size, &pattern_size) != 3 ||
+            data.size() - end - 1 < structure_size + pattern_size)
+            return false;
+        pos = end + 1;
+        Store(data.substr(pos, structure_size), status, data.substr(pos + structure_size, pattern_size));
+        pos += structure_size + pattern_size;
+    }
+    return true;
+}
+
+bool StructureCache::Save(const string& path) const {
+    string data = kMagic + options_ + '\n';
+    pthread_mutex_lock(&mutex_);
+    for (list<Entry>::const_reverse_iterator i = entries_.rbegin(); i != entries_.rend(); ++i) {
+        char line[64];
+        snprintf(line, sizeof(line), "%d %lu %lu\n", i->status, static_cast<unsigned long>(i->structure.size()),
+                 static_cast<unsigned long>(i->pattern.size()));
+        data += line + i->structure + i->pattern;
+    }
+    pthread_mutex_unlock(&mutex_);
+    string temp = path + ".XXXXXX";
+    int fd = mkstemp(&temp[0]);
+    if (fd < 0)
+        return false;
+    const char* ptr = data.data();
+    size_t size = data.size();
+    while (size > 0) {
+        ssize_t n = write(fd, ptr, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        ptr += n;
+        size -= n;
+    }
+    if (close(fd) == 0 && size == 0 && rename(temp.c_str(), path.c_str()) == 0)
+        return true;
+    unlink(temp.c_str());
+    return false;
+}
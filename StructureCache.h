@@ -0,0 +1,75 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#ifndef STRUCTURECACHE_H
+#define STRUCTURECACHE_H
+
+#include <list>
+#include <map>
+#include <pthread.h>
+#include <string>
+#include "Hash.h"
+
+using std::list;
+using std::map;
+using std::string;
+
+// A cache of search results keyed by an exact description of the searched
+// neighborhood, so that a structure that shows up again, in another function
+// or another script, is searched only once. Entries are found by the hash of
+// the description and verified against the whole description. They are
+// evicted, least recently used first, once they take more than the capacity,
+// and may be saved to a file and loaded back by a later run. Lookups and
+// stores may come from any number of threads.
+class StructureCache {
+    public:
+        // The capacity is in bytes. options describes everything besides the
+        // structures that the results depend on; a file saved under other
+        // options is not loaded.
+        StructureCache(size_t capacity, const string& options);
+        ~StructureCache();
+
+        // Returns false on a miss.
+        bool Lookup(const string& structure, int* status, string* pattern);
+        void Store(const string& structure, int status, const string& pattern);
+
+        // Returns false if the file cannot be read or does not match.
+        bool Load(const string& path);
+        // The file is written to a temporary file first and then renamed into
+        // place, so concurrent savers leave one of their caches behind. The
+        // cache may be in use meanwhile.
+        bool Save(const string& path) const;
+
+    private:
+        struct Entry {
+            Hash128 key;
+            string structure;
+            int status;
+            string pattern;
+        };
+
+        const size_t capacity_;
+        const string options_;
+        mutable pthread_mutex_t mutex_;
+        size_t size_;  // bytes taken by the entries
+        list<Entry> entries_;  // most recently used first
+        map<Hash128,list<Entry>::iterator> index_;
+
+        static inline size_t Cost(const Entry& entry) { return sizeof(Entry) + entry.structure.size() + entry.pattern.size(); }
+};
+
+#endif // STRUCTURECACHE_H
@@ -0,0 +1,84 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#include "UnfoldingExtractor.h"
+
+using std::make_pair;
+
+void UnfoldingExtractor::Extract(int node, int n, bool long_desc, Ngram* ngram) {
+    while (levels_.size() < static_cast<size_t>(n))
+        Unfold();
+    const Level& level = levels_[n - 1];
+    *ngram = Ngram();
+    ngram->pattern = Output(level.trees[node].ToHex());
+    if (long_desc) {
+        ngram->size = level.sizes[node];
+        ngram->op = graph_.op(node);
+        ngram->context = Output(level.contexts[node].ToHex());
+    }
+}
+
+static inline void AppendHash(string* s, const Hash128& hash) {
+    s->append(reinterpret_cast<const char*>(&hash), sizeof(hash));
+}
+
+// Hashes the trees one level deeper than the deepest ones so far. A tree is
+// hashed as the label of its root followed by its children, each as a flag
+// and the hash of its subtree, sorted so that their order does not matter;
+// its context is hashed the same way without the label.
+void UnfoldingExtractor::Unfold() {
+    const size_t depth = levels_.size();
+    levels_.resize(depth + 1);
+    Level& level = levels_.back();
+    level.trees.resize(graph_.size());
+    level.contexts.resize(graph_.size());
+    level.sizes.resize(graph_.size());
+    if (depth == 0) {
+        for (int i = 0; i < graph_.size(); ++i) {
+            int type = graph_.type(i);
+            buffer_.assign(reinterpret_cast<const char*>(&type), sizeof(type));
+            buffer_ += graph_.op(i);
+            level.trees[i] = Hash128(buffer_.data(), buffer_.size());
+            level.contexts[i] = Hash128("", 0);
+            level.sizes[i] = 1;
+        }
+        return;
+    }
+
+    const Level& labels = levels_.front();
+    const Level& subtrees = levels_[depth - 1];
+    for (int i = 0; i < graph_.size(); ++i) {
+        DependenceGraph::Ids predecessors = graph_.predecessors(i);
+        size_t size = 1;
+        children_.clear();
+        for (DependenceGraph::Ids::const_iterator j = predecessors.begin(); j != predecessors.end(); ++j) {
+            // loop-carried dependences come from lexically later statements
+            children_.push_back(make_pair(lexical_order_[*j] > lexical_order_[i], subtrees.trees[*j]));
+            size = size + subtrees.sizes[*j] < size ? static_cast<size_t>(-1) : size + subtrees.sizes[*j];
+        }
+        sort(children_.begin(), children_.end());
+        buffer_.clear();
+        AppendHash(&buffer_, labels.trees[i]);
+        for (vector<pair<bool,Hash128> >::iterator j = children_.begin(); j != children_.end(); ++j) {
+            buffer_ += j->first ? '>' : '<';
+            AppendHash(&buffer_, j->second);
+        }
+        level.trees[i] = Hash128(buffer_.data(), buffer_.size());
+        level.contexts[i] = Hash128(buffer_.data() + sizeof(Hash128), buffer_.size() - sizeof(Hash128));
+        level.sizes[i] = size;
+    }
+}
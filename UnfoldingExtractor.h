@@ -0,0 +1,79 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#ifndef UNFOLDINGEXTRACTOR_H
+#define UNFOLDINGEXTRACTOR_H
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+#include "DependenceGraph.h"
+#include "Hash.h"
+#include "NgramExtractor.h"
+
+using std::pair;
+using std::sort;
+using std::string;
+using std::vector;
+
+// Extracts the hash of the backward unfolding tree of a statement: the tree
+// of depth n rooted at the statement, whose children are the unfolding trees
+// of depth n - 1 of its predecessors, each tagged by whether the predecessor
+// comes earlier lexically. Isomorphic trees get the same hash, which is n
+// rounds of Weisfeiler-Lehman relabeling with the ops as initial labels. The
+// trees of a depth are hashed for all the statements at once, from the ones
+// of the depth below, so a script takes O(n E) work and has no size limit.
+// Unlike the neighborhoods of PDGExtractor, the trees repeat statements
+// reached along several paths and cannot tell them apart.
+class UnfoldingExtractor : public NgramExtractor {
+    public:
+        // The lexical order of the statements of graph is given by cmp, which
+        // compares ids.
+        template <class Compare> UnfoldingExtractor(const DependenceGraph& graph, Compare cmp)
+            : graph_(graph), lexical_order_(graph.size()) {
+            vector<int> nodes;
+            for (int i = 0; i < graph.size(); ++i)
+                nodes.push_back(i);
+            sort(nodes.begin(), nodes.end(), cmp);
+            for (size_t i = 0; i < nodes.size(); ++i)
+                lexical_order_[nodes[i]] = i;
+        }
+
+        // The n-gram is the hash in hex. The long description adds the number
+        // of nodes of the tree, the op of the statement, and the hash of the
+        // tree without the label of its root as the context.
+        using NgramExtractor::Extract;
+        void Extract(int node, int n, bool long_desc, Ngram* ngram);
+
+    private:
+        struct Level {
+            vector<Hash128> trees;  // by id
+            vector<Hash128> contexts;
+            vector<size_t> sizes;
+        };
+
+        void Unfold();
+
+        const DependenceGraph& graph_;
+        vector<int> lexical_order_;  // by id
+        vector<Level> levels_;  // by depth - 1
+        vector<pair<bool,Hash128> > children_;  // reused by every tree
+        string buffer_;
+};
+
+#endif // UNFOLDINGEXTRACTOR_H
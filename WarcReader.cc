@@ -0,0 +1,210 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#include "WarcReader.h"
+
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+using std::cerr;
+using std::endl;
+
+// Inflates a zlib, gzip or raw deflate stream, as told by window_bits (see
+// inflateInit2), into out. Returns false if the stream is corrupt or cut off.
+static bool Inflate(const string& data, int window_bits, string* out) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, window_bits) != Z_OK)
+        return false;
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = data.size();
+    out->clear();
+    char buf[65536];
+    int status;
+    do {
+        stream.next_out = reinterpret_cast<Bytef*>(buf);
+        stream.avail_out = sizeof(buf);
+        status = inflate(&stream, Z_NO_FLUSH);
+        out->append(buf, sizeof(buf) - stream.avail_out);
+    } while (status == Z_OK);
+    inflateEnd(&stream);
+    return status == Z_STREAM_END;
+}
+
+// Undoes the content coding of an HTTP body.
+static bool Decode(const string& encoding, string* body) {
+    if (encoding.empty() || strcasecmp(encoding.c_str(), "identity") == 0)
+        return true;
+    string data;
+    data.swap(*body);
+    bool inflated;
+    if (strcasecmp(encoding.c_str(), "gzip") == 0 || strcasecmp(encoding.c_str(), "x-gzip") == 0) {
+        inflated = Inflate(data, 16 + MAX_WBITS, body);
+    } else if (strcasecmp(encoding.c_str(), "deflate") == 0) {
+        // meant to be zlib, but often sent raw
+        inflated = Inflate(data, MAX_WBITS, body) || Inflate(data, -MAX_WBITS, body);
+    } else {
+        cerr << "Skipping a response in content coding " << encoding << endl;
+        return false;
+    }
+    if (!inflated)
+        cerr << "Skipping a corrupt " << encoding << " response" << endl;
+    return inflated;
+}
+
+// Returns the value of a "Name: value" header line if it has the given name.
+static bool GetHeader(const string& line, const char* name, string* value) {
+    size_t size = strlen(name);
+    if (line.size() <= size || line[size] != ':' || strncasecmp(line.c_str(), name, size) != 0)
+        return false;
+    size_t begin = line.find_first_not_of(" \t", size + 1);
+    size_t end = line.find_last_not_of(" \t\r\n");
+    *value = begin == string::npos || end < begin ? "" : line.substr(begin, end - begin + 1);
+    return true;
+}
+
+bool WarcReader::Open(const string& path) {
+    Close();
+    file_ = gzopen(path.c_str(), "rb");
+    if (file_ == NULL) {
+        cerr << "Cannot open " << path << endl;
+        return false;
+    }
+    gzbuffer(file_, 1 << 20);
+    path_ = path;
+    return true;
+}
+
+void WarcReader::Close() {
+    if (file_ != NULL)
+        gzclose(file_);
+    file_ = NULL;
+}
+
+bool WarcReader::ReadLine(string* line) {
+    line->clear();
+    char buf[4096];
+    while (gzgets(file_, buf, sizeof(buf)) != NULL) {
+        line->append(buf);
+        if (!line->empty() && (*line)[line->size() - 1] == '\n')
+            return true;
+    }
+    return !line->empty();
+}
+
+bool WarcReader::Next(Record* record) {
+    if (file_ == NULL)
+        return false;
+
+    // skip the blank lines that end the previous record
+    string line;
+    do {
+        if (!ReadLine(&line))
+            return false;
+    } while (line == "\r\n" || line == "\n");
+    if (line.compare(0, 5, "WARC/") != 0) {
+        cerr << "Malformed WARC record in " << path_ << endl;
+        return false;
+    }
+
+    record->type.clear();
+    record->uri.clear();
+    long length = -1;
+    string value;
+    while (ReadLine(&line) && line != "\r\n" && line != "\n") {
+        if (GetHeader(line, "WARC-Type", &value))
+            record->type = value;
+        else if (GetHeader(line, "WARC-Target-URI", &value))
+            record->uri = value;
+        else if (GetHeader(line, "Content-Length", &value))
+            length = strtol(value.c_str(), NULL, 10);
+    }
+    if (length < 0) {
+        cerr << "Malformed WARC record in " << path_ << endl;
+        return false;
+    }
+
+    record->content.resize(length);
+    for (long size = 0; size < length; ) {
+        int n = gzread(file_, &record->content[size], length - size);
+        if (n <= 0) {
+            cerr << "Truncated WARC record in " << path_ << endl;
+            return false;
+        }
+        size += n;
+    }
+    return true;
+}
+
+bool WarcReader::ParseResponse(const string& response, string* content_type, string* body) {
+    size_t end = response.find("\r\n\r\n");
+    size_t begin = end + 4;
+    if (end == string::npos) {
+        end = response.find("\n\n");
+        begin = end + 2;
+    }
+    if (end == string::npos)
+        return false;
+
+    // status line
+    size_t eol = response.find('\n');
+    size_t space = response.find(' ');
+    if (response.compare(0, 5, "HTTP/") != 0 || space > eol || atoi(response.c_str() + space + 1) != 200)
+        return false;
+
+    content_type->clear();
+    string encoding;
+    bool chunked = false;
+    string value;
+    for (size_t pos = eol + 1; pos < end; pos = eol + 1) {
+        eol = response.find('\n', pos);
+        if (eol == string::npos || eol > end)
+            eol = end;
+        string line = response.substr(pos, eol - pos);
+        if (GetHeader(line, "Content-Type", &value))
+            *content_type = value;
+        else if (GetHeader(line, "Content-Encoding", &value))
+            encoding = value;
+        else if (GetHeader(line, "Transfer-Encoding", &value))
+            chunked = strncasecmp(value.c_str(), "chunked", 7) == 0;
+    }
+
+    if (!chunked) {
+        body->assign(response, begin, string::npos);
+        return Decode(encoding, body);
+    }
+    body->clear();
+    for (size_t pos = begin; pos < response.size(); ) {
+        eol = response.find('\n', pos);
+        if (eol == string::npos)
+            return false;
+        size_t size = strtoul(response.c_str() + pos, NULL, 16);
+        if (size == 0)
+            break;
+        if (eol + 1 + size > response.size())
+            return false;
+        body->append(response, eol + 1, size);
+        // skip the CRLF after the chunk
+        pos = response.find('\n', eol + 1 + size);
+        if (pos == string::npos)
+            break;
+        ++pos;
+    }
+    return Decode(encoding, body);
+}
@@ -0,0 +1,57 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+#ifndef WARCREADER_H
+#define WARCREADER_H
+
+#include <string>
+#include <zlib.h>
+
+using std::string;
+
+// Reads the records of a WARC file one at a time. The file may be plain or
+// gzip'd, either as a whole or record by record.
+class WarcReader {
+    public:
+        struct Record {
+            string type;  // WARC-Type
+            string uri;  // WARC-Target-URI
+            string content;
+        };
+
+        WarcReader() : file_(NULL) { }
+        ~WarcReader() { Close(); }
+
+        bool Open(const string& path);
+        void Close();
+        // Returns false at the end of the file or on a malformed record.
+        bool Next(Record* record);
+
+        // Splits an HTTP response into its Content-Type and its body, which
+        // is de-chunked and inflated if needed. Returns false if the response
+        // is not a complete one with status 200, or if its body is in a
+        // content coding other than gzip or deflate.
+        static bool ParseResponse(const string& response, string* content_type, string* body);
+
+    private:
+        gzFile file_;
+        string path_;
+
+        bool ReadLine(string* line);
+};
+
+#endif // WARCREADER_H
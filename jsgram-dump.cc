@@ -0,0 +1,56 @@
+// Copyright (C) 2013 The University of Michigan
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Authors - Chun-Hung Hsiao (chhsiao@umich.edu)
+//
+
+// Decodes the binary output of jsgram -f binary back into the text format.
+
+#include <fstream>
+#include <iostream>
+#include "NgramWriter.h"
+
+using namespace std;
+
+int main(int argc, char **argv) {
+    ifstream file;
+    if (argc > 1) {
+	file.open(argv[1], ios::in | ios::binary);
+	if (!file) {
+	    cerr << "Cannot open " << argv[1] << endl;
+	    return 1;
+	}
+    }
+    BinaryNgramReader reader(argc > 1 ? &file : &cin);
+
+    int flags;
+    if (!reader.ReadHeader(&flags)) {
+	cerr << "Not a jsgram binary stream" << endl;
+	return 1;
+    }
+    TextNgramWriter writer(&cout, flags & BinaryNgramWriter::kTagged, flags & BinaryNgramWriter::kDescriptions,
+			   flags & BinaryNgramWriter::kPositions, flags & BinaryNgramWriter::kRadii);
+    BinaryNgramReader::Record record;
+    while (reader.Next(&record)) {
+	if (record.kind == BinaryNgramReader::kScript)
+	    writer.BeginScript(record.path);
+	else if (record.kind == BinaryNgramReader::kNgram)
+	    writer.Write(record.line, record.func, record.n, record.ngram);
+    }
+    if (reader.malformed()) {
+	cerr << "Malformed record" << endl;
+	return 1;
+    }
+    return 0;
+}
@@ -16,175 +16,211 @@
 //
 
 #include <algorithm>
-#include <fstream>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
-#include <iterator>
-#include <limits>
-#include <ast.h>
-#include <token.h>
-#include <scanner-character-streams.h>
-#include <parser.h>
-#include <api.h>
-#include <compiler.h>
 #include <string>
 #include <unistd.h>
-#include <utility>
 #include <v8.h>
-#include "CanonicalAst.h"
-#include "DependenceGraph.h"
-#include "CodePrinter.h"
-#include "NgramExtractor.h"
-#include "PDGExtractor.h"
-#include "SequenceExtractor.h"
-#include "Utility.h"
+#include "NgramWriter.h"
+#include "ScriptList.h"
+#include "ScriptPool.h"
+#include "ScriptProcessor.h"
+#include "ScriptSupervisor.h"
+#include "SqliteNgramWriter.h"
 
 using namespace std;
-using namespace v8::internal;
 
 int main(int argc, char **argv) {
     int opt;
-    enum {EXTRACT, PRINT, LIST} mode = EXTRACT;
-    enum {PDG, SEQUENCE} type = PDG;
-    int n = 3;
-    while ((opt = getopt(argc, argv, "pn:ls")) != -1) {
+    ScriptOptions options;
+    ScriptList scripts;
+    bool batch = false;
+    int jobs = 1;
+    int workers = 0;
+    int time_limit = 60;
+    bool ordered = false;
+    while ((opt = getopt(argc, argv, "pn:lsub:r:W:j:kw:t:m:e:c:ivf:d:D:C:FM:S:L:T:P:g")) != -1) {
 	switch (opt) {
 	    case 'p':
-		mode = PRINT;
+		options.mode = ScriptOptions::PRINT;
 		break;
 	    case 'n':
-		n = atoi(optarg);
+		// either <n> or <min>-<max>
+		options.n = options.max_n = atoi(optarg);
+		if (strchr(optarg, '-'))
+		    options.max_n = atoi(strchr(optarg, '-') + 1);
+		if (options.n < 1 || options.max_n < options.n) {
+		    cerr << "Invalid n-gram depth " << optarg << endl;
+		    return 1;
+		}
 		break;
 	    case 'l':
-		mode = LIST;
+		options.mode = ScriptOptions::LIST;
+		break;
+	    case 'P':
+		options.mode = ScriptOptions::DUMP;
+		options.graph_dir = optarg;
+		break;
+	    case 'g':
+		options.graphs = true;
 		break;
             case 's':
-                type = SEQUENCE;
+                options.type = ScriptOptions::SEQUENCE;
                 break;
+            case 'u':
+                options.type = ScriptOptions::UNFOLDING;
+                break;
+	    case 'm':
+		options.size_limit = strtoul(optarg, NULL, 10);
+		break;
+	    case 'e':
+		options.cost_limit = strtoul(optarg, NULL, 10);
+		break;
+	    case 'c':
+		options.count_limit = strtoul(optarg, NULL, 10);
+		break;
+	    case 'i':
+		options.refine = true;
+		break;
+	    case 'v':
+		options.verbose = true;
+		break;
+	    case 'f':
+		if (string(optarg) == "binary") {
+		    options.format = ScriptOptions::BINARY;
+		} else if (string(optarg) != "text") {
+		    cerr << "Invalid format " << optarg << endl;
+		    return 1;
+		}
+		break;
+	    case 'd':
+	    case 'D':
+		options.format = ScriptOptions::SQLITE;
+		options.database = optarg;
+		options.split_database = opt == 'D';
+		break;
+	    case 'C':
+		options.cache_dir = optarg;
+		break;
+	    case 'M':
+		options.dictionary = optarg;
+		// fall through
+	    case 'F':
+		options.fingerprint = true;
+		break;
+	    case 'S':
+		options.structure_cache = optarg;
+		break;
+	    case 'L':
+		options.structure_cache_size = strtoul(optarg, NULL, 10) << 20;
+		break;
+	    case 'b':
+		scripts.AddList(optarg);
+		batch = true;
+		break;
+	    case 'r':
+		scripts.AddDirectory(optarg);
+		batch = true;
+		break;
+	    case 'W':
+		scripts.AddWarc(optarg);
+		batch = true;
+		break;
+	    case 'j':
+		jobs = atoi(optarg);
+		break;
+	    case 'T':
+		options.threads = atoi(optarg);
+		break;
+	    case 'k':
+		ordered = true;
+		break;
+	    case 'w':
+		workers = atoi(optarg);
+		break;
+	    case 't':
+		time_limit = atoi(optarg);
+		break;
 	    default:
 		cerr << "Invalid option -" << static_cast<char>(opt) << endl;
 	}
     }
 
-    v8::Persistent<v8::Context> context = v8::Context::New();
-    context->Enter();
-    ifstream input(argv[optind]);
-    string code((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
-    Utf8ToUtf16CharacterStream stream(reinterpret_cast<const unsigned char*>(code.c_str()), code.length());
-    HandleScope handle_scope;
-    Handle<Script> script = FACTORY->NewScript(v8::Utils::OpenHandle(*v8::String::New(code.c_str())));
-    CompilationInfo info(script, handle_scope.isolate()->runtime_zone());
-    info.MarkAsGlobal();
-    if (!ParserApi::Parse(&info, kNoParsingFlags)) {
-    	cerr << "Cannot parse " << argv[optind] << endl;
+    if (!options.structure_cache.empty() && !options.structure_cache_size)
+	options.structure_cache_size = 64 << 20;
+
+    if (options.graphs && options.mode != ScriptOptions::EXTRACT) {
+	cerr << "Graph files can only be extracted from" << endl;
 	return 1;
     }
-    if (info.function()->ast_node_count() == 0) {
-    	cerr << "Cannot parse " << argv[optind] << endl;
+
+    // worker processes cannot pool what they add to the structure cache
+    if (!options.structure_cache.empty() && workers > 0) {
+	cerr << "The structure cache file cannot be used with worker processes" << endl;
 	return 1;
     }
-    ZoneScope zone_scope(handle_scope.isolate()->runtime_zone(), DELETE_ON_EXIT);
-    if (!Scope::Analyze(&info)) {
-    	cerr << "Cannot parse " << argv[optind] << endl;
+
+    if (batch) {
+	for (int i = optind; i < argc; ++i)
+	    scripts.AddFile(argv[i]);
+	options.tag = true;
+    } else if (optind < argc) {
+	scripts.AddFile(argv[optind]);
+	if (optind + 1 < argc)
+	    options.line = atoi(argv[optind + 1]);
+    } else {
+	cerr << "No input script" << endl;
 	return 1;
     }
 
-    CanonicalAstConverter().Convert(&info);
-    DependenceGraphBuilder builder;
-    builder.Build(info.function());
-    CodePrinter printer(info.function());
-
-    NgramExtractor *extractor = NULL;
-    switch (type) {
-        case PDG:
-            extractor = new PDGExtractor(builder.GetGraph(), mem_fun_less(&printer, &CodePrinter::CompareNode), 40);
-            break;
-
-        case SEQUENCE:
-            extractor = new SequenceExtractor(key_iterator<DependenceGraph>(builder.GetGraph().begin()),
-                                              key_iterator<DependenceGraph>(builder.GetGraph().end()),
-                                              mem_fun_less(&printer, &CodePrinter::CompareNode));
-            break;
+    if (options.mode == ScriptOptions::EXTRACT && options.format == ScriptOptions::BINARY) {
+	BinaryNgramWriter::WriteHeader(&cout, (options.tag ? BinaryNgramWriter::kTagged : 0) |
+					      (options.Descriptions() ? BinaryNgramWriter::kDescriptions : 0) |
+					      (options.line ? 0 : BinaryNgramWriter::kPositions) |
+					      (options.n < options.max_n ? BinaryNgramWriter::kRadii : 0));
     }
 
-    Statement* node = argv[optind + 1] ? printer.GetLine(atoi(argv[optind + 1])) : NULL;
-
-    switch (mode) {
-    	case EXTRACT:
-	    if (node) {
-	    	string pattern = extractor->Extract(node, n, true);
-	    	if (pattern != "") {
-		    cout << pattern << endl;
-		} else {
-		    cerr << "Cannot extract " << n << "-gram for " << argv[optind] << ":" << argv[optind + 1] << endl;
-		}
-	    } else {
-	    	for (size_t i = 1; i <= printer.NumLines(); ++i) {
-	    	    node = printer.GetLine(i);
-	    	    if (!builder.GetGraph().count(node))
-	    	    	continue;
-		    string pattern = extractor->Extract(node, n, true);
-	    	    if (pattern != "") {
-			cout << pattern << '\t' << i << '\t' << printer.GetFuncNo(node) << endl;
-		    } else
-			cerr << "Cannot extract " << n << "-gram for " << argv[optind] << ":" << i << endl;
-		}
-	    }
-	    break;
-
-	case PRINT:
-	    if (node) {
-	    	CanonicalFunctionEntry* function = (CanonicalFunctionEntry*)printer.GetLine(printer.GetFuncNo(node));
-	    	printer.Print(function->literal(), builder.GetGraph().GetNeighborhood(node, n), builder.GetSuccessors(node));
-	    }
-	    cout << printer.GetOutput();
-	    break;
-
-/*
-	case DEPEND:
-	    if (node) {
-		DependenceGraph neighborhood1 = extractor.FindNeighborhood(node, n);
-		for (list<Statement*>::const_iterator j = builder.GetGraph().at(node).begin(); j != builder.GetGraph().at(node).end(); ++j) {
-		    const DependenceGraph& neighborhood2 = extractor.FindNeighborhood(*j, n);
-		    int weight = 0;
-		    for (key_iterator<DependenceGraph> l = neighborhood1.begin(); l != neighborhood1.end(); ++l)
-			weight += 1 - neighborhood2.count(*l);
-		    for (key_iterator<DependenceGraph> l = neighborhood2.begin(); l != neighborhood2.end(); ++l)
-			weight += 1 - neighborhood1.count(*l);
-		    cout << printer.GetLineNo(node) << " " << printer.GetLineNo(*j) << " " << weight << endl;
-		}
-	    } else {
-	    	map<Statement*,set<Statement*> > neighbors;
-	    	for (key_iterator<DependenceGraph> i = builder.GetGraph().begin(); i != builder.GetGraph().end(); ++i) {
-	    	    const DependenceGraph& neighborhood = extractor.FindNeighborhood(*i, n);
-	    	    for (key_iterator<DependenceGraph> j = neighborhood.begin(); j != neighborhood.end(); ++j)
-	    	    	neighbors[*i].insert(*j);
-		}
-	    	for (DependenceGraph::const_iterator i = builder.GetGraph().begin(); i != builder.GetGraph().end(); ++i) {
-		    for (list<Statement*>::const_iterator j = i->second.begin(); j != i->second.end(); ++j) {
-		    	int weight = 0;
-		    	for (set<Statement*>::iterator l = neighbors[i->first].begin(); l != neighbors[i->first].end(); ++l)
-		    	    weight += 1 - neighbors[*j].count(*l);
-		    	for (set<Statement*>::iterator l = neighbors[*j].begin(); l != neighbors[*j].end(); ++l)
-		    	    weight += 1 - neighbors[i->first].count(*l);
-			cout << printer.GetLineNo(i->first) << " " << printer.GetLineNo(*j) << " " << weight << endl;
-		    }
-		}
-	    }
-	    break;
-*/
+    if (options.mode == ScriptOptions::EXTRACT && options.format == ScriptOptions::SQLITE) {
+	// Fail early rather than in every worker.
+	int num_databases = options.split_database ? max(max(jobs, workers), 1) : 1;
+	for (int i = 0; i < num_databases; ++i) {
+	    ScriptOptions worker_options = options;
+	    worker_options.worker = i;
+	    if (!SqliteNgramWriter::Prepare(worker_options.DatabasePath()))
+		return 1;
+	}
+    }
 
-	case LIST:
-	    for (key_iterator<const map<int,Statement*> > i =  printer.GetFuncList().begin(); i != printer.GetFuncList().end(); ++i) {
-	    	cout << *i << " ";
-	    	CanonicalFunctionEntry* function = (CanonicalFunctionEntry*)printer.GetLine(*i);
-	    	printer.PrintFunc(function->literal());
-		cout << printer.GetOutput() << endl;
+    // shared by all jobs, and saved once they are done
+    StructureCache* structures = ScriptProcessor::NewStructureCache(options);
+    int failures = 0;
+    if (workers > 0) {
+	// a worker killed with -t keeps the records of the scripts it has finished
+	options.commit_scripts = true;
+	// Workers are forked before V8 is ever initialized in this process.
+	failures = ScriptSupervisor(options, structures, workers, time_limit, ordered).Run(&scripts, &cout);
+    } else {
+	v8::V8::Initialize();
+	if (jobs > 1) {
+	    failures = ScriptPool(options, structures, jobs, ordered).Run(&scripts, &cout);
+	} else {
+	    ScriptProcessor processor(options, structures);
+	    string path;
+	    string content;
+	    string output;
+	    while (scripts.Next(&path, &content)) {
+		bool success = content.empty() ? processor.Process(path, &output) : processor.Process(path, content, &output);
+		if (!success)
+		    ++failures;
+		cout.write(output.data(), output.size());
 	    }
+	}
+	v8::V8::Dispose();
+	if (structures && !options.structure_cache.empty() && !structures->Save(options.structure_cache))
+	    cerr << "Cannot save " << options.structure_cache << endl;
     }
+    delete structures;
 
-    delete extractor;
-    context->Exit();
-    context.Dispose();
-
-    return 0;
+    return !batch && failures ? 1 : 0;
 }